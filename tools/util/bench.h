@@ -0,0 +1,403 @@
+#pragma once
+
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A small benchmark runner on top of Timer: warms up, samples until the confidence interval
+// of the mean is tight enough, reports robust statistics and checks them against a JSON
+// baseline.
+//
+//     BenchSuite suite;
+//     suite.Add("sort_1m", [&] { auto copy = data; std::ranges::sort(copy); KeepAlive(copy); });
+//     const bool ok = suite.Run(std::cout, {.path = "bench_baseline.json"});
+
+// Keeps the compiler from dropping a computation whose result is otherwise unused.
+template <class T>
+void KeepAlive(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");  // NOLINT(hicpp-no-assembler)
+}
+
+struct BenchOptions {
+    // Untimed runs before sampling, to warm caches, the allocator and the branch predictors.
+    int warmup = 3;
+    int min_samples = 10;
+    int max_samples = 1000;
+    // Sampling stops once the 95% confidence interval of the mean is within this fraction of
+    // it, or after max_time.
+    double relative_interval = 0.01;
+    std::chrono::milliseconds max_time{10'000};
+    // Each sample times a batch of runs lasting at least this long, so that clock resolution
+    // and overhead do not dominate short bodies.
+    std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds{1};
+};
+
+// Times in nanoseconds per run.
+struct BenchResult {
+    std::string name;
+    size_t samples = 0;
+    // Runs per sample.
+    size_t batch = 0;
+    double median = 0.;
+    double p90 = 0.;
+    double p99 = 0.;
+    // Median absolute deviation from the median.
+    double mad = 0.;
+    // Half-width of the 95% confidence interval of the mean, relative to the mean.
+    double relative_interval = 0.;
+    // Above 1 when the body keeps several threads busy, below 1 when it waits.
+    double cpu_ratio = 0.;
+};
+
+inline BenchResult RunBenchmark(
+    std::string_view name, const std::function<void()>& body, const BenchOptions& options) {
+    for (int i = 0; i < options.warmup; ++i) {
+        body();
+    }
+    using Clock = std::chrono::steady_clock;
+    using Nanoseconds = std::chrono::duration<double, std::nano>;
+    const auto run_batch = [&body](size_t batch) {
+        const auto start = Clock::now();
+        for (size_t i = 0; i < batch; ++i) {
+            body();
+        }
+        return Clock::now() - start;
+    };
+    // Doubles the batch until it lasts min_sample_time; these runs count as extra warmup.
+    size_t batch = 1;
+    while (run_batch(batch) < options.min_sample_time) {
+        batch *= 2;
+    }
+
+    // CPU time is read once for the whole loop: getrusage per sample would cost more than
+    // short bodies and has coarse resolution anyway.
+    const Timer total;
+    const auto start = Clock::now();
+    std::vector<double> samples;
+    double mean = 0.;
+    double m2 = 0.;
+    double relative_interval = 0.;
+    while (std::cmp_less(samples.size(), options.max_samples)) {
+        const double sample =
+            Nanoseconds{run_batch(batch)}.count() / static_cast<double>(batch);
+        samples.push_back(sample);
+        // Welford's running mean and variance.
+        const double delta = sample - mean;
+        mean += delta / static_cast<double>(samples.size());
+        m2 += delta * (sample - mean);
+        const auto n = static_cast<double>(samples.size());
+        relative_interval = samples.size() > 1 && mean > 0.
+                                ? 1.96 * std::sqrt(m2 / (n - 1) / n) / mean
+                                : 0.;
+        if (std::cmp_greater_equal(samples.size(), options.min_samples) &&
+            (relative_interval <= options.relative_interval ||
+             Clock::now() - start >= options.max_time)) {
+            break;
+        }
+    }
+    const auto times = total.GetTimes();
+
+    std::ranges::sort(samples);
+    // Nearest rank.
+    const auto percentile = [](const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) {
+            return 0.;
+        }
+        const auto rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    };
+    BenchResult result;
+    result.name = name;
+    result.samples = samples.size();
+    result.batch = batch;
+    result.median = percentile(samples, 0.5);
+    result.p90 = percentile(samples, 0.9);
+    result.p99 = percentile(samples, 0.99);
+    std::vector<double> deviations;
+    deviations.reserve(samples.size());
+    for (const double sample : samples) {
+        deviations.push_back(std::abs(sample - result.median));
+    }
+    std::ranges::sort(deviations);
+    result.mad = percentile(deviations, 0.5);
+    result.relative_interval = relative_interval;
+    const double wall = Nanoseconds{times.wall_time}.count();
+    result.cpu_ratio = wall > 0. ? Nanoseconds{times.cpu_time}.count() / wall : 0.;
+    return result;
+}
+
+// Stored statistics per benchmark, read from and written to a flat JSON object:
+//
+//     {
+//       "sort_1m": {"median_ns": 81234567, "p90_ns": 83000000, "mad_ns": 412345},
+//       ...
+//     }
+//
+// Only objects, strings and numbers are supported, which is all Save writes.
+class BenchBaseline {
+   public:
+    using Entry = std::map<std::string, double>;
+
+    // An empty baseline if the file does not exist; throws std::runtime_error if it cannot
+    // be parsed.
+    static BenchBaseline Load(const std::filesystem::path& path) {
+        BenchBaseline baseline;
+        std::ifstream in{path};
+        if (!in) {
+            return baseline;
+        }
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        const std::string text = buffer.str();
+        Parser parser{text};
+        baseline.entries_ = parser.Baseline();
+        return baseline;
+    }
+
+    void Save(const std::filesystem::path& path) const {
+        std::ofstream out{path};
+        out << std::setprecision(17) << "{";
+        for (auto bench = entries_.begin(); bench != entries_.end(); ++bench) {
+            out << (bench == entries_.begin() ? "\n" : ",\n") << "  " << Quoted(bench->first)
+                << ": {";
+            for (auto field = bench->second.begin(); field != bench->second.end(); ++field) {
+                out << (field == bench->second.begin() ? "" : ", ") << Quoted(field->first)
+                    << ": " << field->second;
+            }
+            out << "}";
+        }
+        out << "\n}\n";
+        if (!out.flush()) {
+            throw std::runtime_error{"Failed to write " + path.string()};
+        }
+    }
+
+    [[nodiscard]] const Entry* Find(const std::string& name) const {
+        const auto it = entries_.find(name);
+        return it == entries_.end() ? nullptr : &it->second;
+    }
+
+    void Update(const BenchResult& result) {
+        entries_[result.name] = {
+            {"median_ns", result.median}, {"p90_ns", result.p90}, {"p99_ns", result.p99},
+            {"mad_ns", result.mad}, {"cpu_ratio", result.cpu_ratio}};
+    }
+
+   private:
+    // Recursive descent over the subset of JSON above.
+    class Parser {
+       public:
+        explicit Parser(std::string_view text) : text_{text} {
+        }
+
+        std::map<std::string, Entry> Baseline() {
+            std::map<std::string, Entry> entries;
+            Object([&](std::string key) {
+                Entry& entry = entries[std::move(key)];
+                Object([&](std::string field) { entry[std::move(field)] = Number(); });
+            });
+            SkipSpace();
+            if (!text_.empty()) {
+                Fail();
+            }
+            return entries;
+        }
+
+       private:
+        template <class OnMember>
+        void Object(const OnMember& on_member) {
+            Expect('{');
+            if (Consume('}')) {
+                return;
+            }
+            do {
+                std::string key = String();
+                Expect(':');
+                on_member(std::move(key));
+            } while (Consume(','));
+            Expect('}');
+        }
+
+        std::string String() {
+            Expect('"');
+            std::string result;
+            while (!text_.empty() && text_.front() != '"') {
+                if (text_.front() == '\\') {
+                    text_.remove_prefix(1);
+                    if (text_.empty()) {
+                        Fail();
+                    }
+                }
+                result.push_back(text_.front());
+                text_.remove_prefix(1);
+            }
+            Expect('"');
+            return result;
+        }
+
+        double Number() {
+            SkipSpace();
+            double value = 0.;
+            const auto [end, error] =
+                std::from_chars(text_.data(), text_.data() + text_.size(), value);
+            if (error != std::errc{}) {
+                Fail();
+            }
+            text_.remove_prefix(end - text_.data());
+            return value;
+        }
+
+        void SkipSpace() {
+            constexpr std::string_view kSpace = " \t\r\n";
+            while (!text_.empty() && kSpace.find(text_.front()) != std::string_view::npos) {
+                text_.remove_prefix(1);
+            }
+        }
+
+        bool Consume(char c) {
+            SkipSpace();
+            if (!text_.empty() && text_.front() == c) {
+                text_.remove_prefix(1);
+                return true;
+            }
+            return false;
+        }
+
+        void Expect(char c) {
+            if (!Consume(c)) {
+                Fail();
+            }
+        }
+
+        [[noreturn]] static void Fail() {
+            throw std::runtime_error{"Malformed benchmark baseline"};
+        }
+
+        std::string_view text_;
+    };
+
+    static std::string Quoted(const std::string& text) {
+        std::string result = "\"";
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                result.push_back('\\');
+            }
+            result.push_back(c);
+        }
+        return result + '"';
+    }
+
+    std::map<std::string, Entry> entries_;
+};
+
+struct BaselineOptions {
+    // No comparison when empty.
+    std::filesystem::path path;
+    // A benchmark regresses when its median exceeds the baseline's by more than this
+    // fraction plus three of its MADs, so noisy benchmarks need a larger change to fail.
+    double threshold = 0.1;
+    // Rewrites the baseline with the new results instead of failing.
+    bool update = false;
+};
+
+class BenchSuite {
+   public:
+    explicit BenchSuite(
+        BenchOptions options = {})  // NOLINT(fuchsia-default-arguments-declarations)
+        : options_{options} {
+    }
+
+    void Add(std::string name, std::function<void()> body) {
+        benchmarks_.emplace_back(std::move(name), std::move(body));
+    }
+
+    // Runs all benchmarks in order and prints one line per benchmark. Returns false if any
+    // of them regressed against the baseline.
+    bool Run(
+        std::ostream& out,
+        const BaselineOptions& baseline_options = {}) {  // NOLINT(fuchsia-default-arguments-*)
+        BenchBaseline baseline;
+        if (!baseline_options.path.empty()) {
+            baseline = BenchBaseline::Load(baseline_options.path);
+        }
+        bool passed = true;
+        results_.clear();
+        for (const auto& [name, body] : benchmarks_) {
+            const BenchResult& result = results_.emplace_back(RunBenchmark(name, body, options_));
+            out << Format(result);
+            if (const BenchBaseline::Entry* entry = baseline.Find(name);
+                entry != nullptr && entry->contains("median_ns")) {
+                const double before = entry->at("median_ns");
+                const double change = before > 0. ? result.median / before - 1. : 0.;
+                const double allowed =
+                    before * baseline_options.threshold + 3. * result.mad;
+                const bool regressed = result.median - before > allowed;
+                out << "  " << std::showpos << std::fixed << std::setprecision(1)
+                    << 100. * change << std::noshowpos << "% vs baseline"
+                    << (regressed ? "  REGRESSION" : "");
+                passed = passed && (!regressed || baseline_options.update);
+            }
+            out << "\n";
+            if (baseline_options.update) {
+                baseline.Update(result);
+            }
+        }
+        if (baseline_options.update && !baseline_options.path.empty()) {
+            baseline.Save(baseline_options.path);
+        }
+        return passed;
+    }
+
+    [[nodiscard]] const std::vector<BenchResult>& Results() const {
+        return results_;
+    }
+
+   private:
+    static std::string FormatTime(double nanoseconds) {
+        constexpr std::array<std::pair<double, std::string_view>, 3> kUnits = {
+            {{1e9, "s"}, {1e6, "ms"}, {1e3, "us"}}};
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        for (const auto& [scale, unit] : kUnits) {
+            if (nanoseconds >= scale) {
+                out << nanoseconds / scale << " " << unit;
+                return out.str();
+            }
+        }
+        out << nanoseconds << " ns";
+        return out.str();
+    }
+
+    static std::string Format(const BenchResult& result) {
+        std::ostringstream out;
+        out << std::left << std::setw(32) << result.name << " median " << FormatTime(result.median)
+            << "  p90 " << FormatTime(result.p90) << "  p99 " << FormatTime(result.p99)
+            << "  MAD " << FormatTime(result.mad) << std::fixed << std::setprecision(2)
+            << "  cpu/wall " << result.cpu_ratio << "  n=" << result.samples << "x"
+            << result.batch << "  +-" << std::setprecision(1) << 100. * result.relative_interval
+            << "%";
+        return out.str();
+    }
+
+    BenchOptions options_;
+    std::vector<std::pair<std::string, std::function<void()>>> benchmarks_;
+    std::vector<BenchResult> results_;
+};
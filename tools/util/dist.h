@@ -1,34 +1,161 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cmath>
 #include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <initializer_list>
 #include <limits>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <type_traits>
+#include <vector>
+
+// Fills out with uniform random bits from an engine with a full 32- or 64-bit range, through
+// the engine's own Fill(span) when it has one.
+template <class Word, class Gen>
+void FillRandomBits(Gen& gen, std::span<Word> out) {
+    using EngineWord = std::conditional_t<
+        Gen::max() == std::numeric_limits<uint32_t>::max(), uint32_t, uint64_t>;
+    static_assert(std::is_unsigned_v<Word>, "Word must be unsigned");
+    static_assert(
+        Gen::min() == 0 && Gen::max() == std::numeric_limits<EngineWord>::max(),
+        "the engine must produce full 32- or 64-bit words");
+    const auto fill = [&gen](std::span<EngineWord> words) {
+        if constexpr (requires { gen.Fill(words); }) {
+            gen.Fill(words);
+        } else {
+            for (EngineWord& word : words) {
+                word = static_cast<EngineWord>(gen());
+            }
+        }
+    };
+    if constexpr (std::is_same_v<Word, EngineWord>) {
+        fill(out);
+    } else {
+        constexpr size_t kChunk = 64;
+        std::array<EngineWord, kChunk> words;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        auto bytes = std::as_writable_bytes(out);
+        while (!bytes.empty()) {
+            const size_t count =
+                std::min(kChunk, (bytes.size() + sizeof(EngineWord) - 1) / sizeof(EngineWord));
+            fill(std::span<EngineWord>(words.data(), count));
+            const size_t size = std::min(bytes.size(), count * sizeof(EngineWord));
+            std::memcpy(bytes.data(), words.data(), size);
+            bytes = bytes.subspan(size);
+        }
+    }
+}
 
 template <typename IntType = int>
 class UniformIntDistribution {
     static_assert(std::is_integral_v<IntType>, "template argument must be an integral type");
 
    public:
-    UniformIntDistribution() : UniformIntDistribution(0) {
+    constexpr UniformIntDistribution() : UniformIntDistribution(0) {
     }
 
-    explicit UniformIntDistribution(IntType a, IntType b = std::numeric_limits<IntType>::max())
+    explicit constexpr UniformIntDistribution(
+        IntType a, IntType b = std::numeric_limits<IntType>::max())
         : a_{a}, b_{b} {
     }
 
     template <class Gen>
-    IntType operator()(Gen& gen) {
+    IntType operator()(Gen& gen) const {
         return this->operator()(gen, a_, b_);
     }
 
+    // Fills out with values of the same distribution as operator(), though not the same
+    // sequence. For generators with a full 32- or 64-bit range, words are drawn a block at a
+    // time and reduced with Lemire's multiply-shift in a branch-free loop the compiler can
+    // vectorize; the few rejected slots are redrawn in a second pass over the block. Engines
+    // with a Fill(span) of their own produce each block in bulk.
+    template <class Gen>
+    void Fill(Gen& gen, std::span<IntType> out) const;
+
    private:
+    using UType = std::make_unsigned_t<IntType>;
+
     IntType a_;
     IntType b_;
 
+    // Serves a 64-bit engine as a 32-bit one, two words per draw, so narrow ranges stay on
+    // the vectorizable 32-bit path.
+    template <class Gen>
+    class HalfWords {
+       public:
+        explicit HalfWords(Gen& gen) : gen_{gen} {
+        }
+
+        uint32_t operator()() {
+            if (has_rest_) {
+                has_rest_ = false;
+                return static_cast<uint32_t>(rest_ >> 32);
+            }
+            rest_ = gen_();
+            has_rest_ = true;
+            return static_cast<uint32_t>(rest_);
+        }
+
+        // Up to 2 * kMaxWords words per call.
+        void Fill(std::span<uint32_t> out) {
+            constexpr size_t kMaxWords = 128;
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-member-init)
+            std::array<uint64_t, kMaxWords> words;
+            const size_t count = (out.size() + 1) / 2;
+            if constexpr (requires { gen_.Fill(std::span<uint64_t>{}); }) {
+                gen_.Fill(std::span<uint64_t>(words.data(), count));
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    words[i] = gen_();
+                }
+            }
+            std::memcpy(out.data(), words.data(), out.size_bytes());
+        }
+
+       private:
+        Gen& gen_;
+        uint64_t rest_ = 0;
+        bool has_rest_ = false;
+    };
+
+    template <class Wp, class Up, class Gen>
+    static void FillBlocks(Gen& gen, UType a, Up range, std::span<IntType> out) {
+        constexpr size_t kBlock = 256;
+        const Up threshold = -range % range;
+        std::array<Up, kBlock> words;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        while (!out.empty()) {
+            const size_t count = std::min(kBlock, out.size());
+            if constexpr (requires { gen.Fill(std::span<Up>{}); }) {
+                gen.Fill(std::span<Up>(words.data(), count));
+            } else {
+                for (size_t i = 0; i < count; ++i) {
+                    words[i] = static_cast<Up>(gen());
+                }
+            }
+            size_t rejected = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const Wp product = static_cast<Wp>(words[i]) * static_cast<Wp>(range);
+                rejected += static_cast<Up>(product) < threshold ? 1 : 0;
+                out[i] = static_cast<IntType>(
+                    a + static_cast<UType>(product >> std::numeric_limits<Up>::digits));
+            }
+            // At most range / 2^digits of the slots are rejected, usually none.
+            for (size_t i = 0; rejected != 0; ++i) {
+                if (static_cast<Up>(static_cast<Wp>(words[i]) * static_cast<Wp>(range)) <
+                    threshold) {
+                    out[i] = static_cast<IntType>(a + static_cast<UType>(SNd<Wp>(gen, range)));
+                    --rejected;
+                }
+            }
+            out = out.subspan(count);
+        }
+    }
+
     template <class Wp, class Urbg, class Up>
     static Up SNd(Urbg& g, Up range) {
         using UpTraits = std::numeric_limits<Up>;
@@ -50,7 +177,7 @@ class UniformIntDistribution {
     }
 
     template <class Gen>
-    IntType operator()(Gen& urng, IntType a, IntType b);
+    IntType operator()(Gen& urng, IntType a, IntType b) const;
 
     template <class>
     static constexpr auto kDependentFalse = false;
@@ -58,8 +185,7 @@ class UniformIntDistribution {
 
 template <class IntType>
 template <class Gen>
-IntType UniformIntDistribution<IntType>::operator()(Gen& urng, IntType a, IntType b) {
-    using UType = std::make_unsigned_t<IntType>;
+IntType UniformIntDistribution<IntType>::operator()(Gen& urng, IntType a, IntType b) const {
     using UCType = std::common_type_t<typename Gen::result_type, UType>;
 
     constexpr UCType kUrngMin = Gen::min();
@@ -90,19 +216,24 @@ IntType UniformIntDistribution<IntType>::operator()(Gen& urng, IntType a, IntTyp
             } while (ret >= past);
             ret /= scaling;
         }
-    } else if (kUrngRange < urange) {
-        const UCType uerngrange = kUrngRange + 1;
-        if (uerngrange == 0) {
-            __builtin_unreachable();
-        }
-        UCType tmp;
-        do {  // NOLINT(cppcoreguidelines-avoid-do-while)
+    } else if constexpr (kUrngRange < std::numeric_limits<UType>::max()) {
+        // Only reachable when IntType is wider than the engine's words.
+        if (kUrngRange < urange) {
+            const UCType uerngrange = kUrngRange + 1;
             if (uerngrange == 0) {
-                throw std::runtime_error("");
+                __builtin_unreachable();
             }
-            tmp = (uerngrange * operator()(urng, 0, urange / uerngrange));
-            ret = tmp + (static_cast<UCType>(urng()) - kUrngMin);
-        } while (ret > urange || ret < tmp);
+            UCType tmp;
+            do {  // NOLINT(cppcoreguidelines-avoid-do-while)
+                if (uerngrange == 0) {
+                    throw std::runtime_error("");
+                }
+                tmp = (uerngrange * operator()(urng, 0, urange / uerngrange));
+                ret = tmp + (static_cast<UCType>(urng()) - kUrngMin);
+            } while (ret > urange || ret < tmp);
+        } else {
+            ret = static_cast<UCType>(urng()) - kUrngMin;
+        }
     } else {
         ret = static_cast<UCType>(urng()) - kUrngMin;
     }
@@ -110,42 +241,656 @@ IntType UniformIntDistribution<IntType>::operator()(Gen& urng, IntType a, IntTyp
     return ret + a;
 }
 
+template <class IntType>
+template <class Gen>
+void UniformIntDistribution<IntType>::Fill(Gen& gen, std::span<IntType> out) const {
+    using UCType = std::common_type_t<typename Gen::result_type, UType>;
+
+    constexpr UCType kUrngRange = Gen::max() - Gen::min();
+    const UCType urange = static_cast<UCType>(b_) - static_cast<UCType>(a_);
+    if constexpr (Gen::min() == 0 && kUrngRange == std::numeric_limits<uint32_t>::max()) {
+        if (urange < kUrngRange) {
+            FillBlocks<uint64_t, uint32_t>(
+                gen, static_cast<UType>(a_), static_cast<uint32_t>(urange + 1), out);
+            return;
+        }
+    } else if constexpr (Gen::min() == 0 && kUrngRange == std::numeric_limits<uint64_t>::max()) {
+        if (urange < std::numeric_limits<uint32_t>::max()) {
+            HalfWords<Gen> words{gen};
+            FillBlocks<uint64_t, uint32_t>(
+                words, static_cast<UType>(a_), static_cast<uint32_t>(urange + 1), out);
+            return;
+        }
+        if (urange < kUrngRange) {
+            __extension__ FillBlocks<unsigned __int128, uint64_t>(
+                gen, static_cast<UType>(a_), static_cast<uint64_t>(urange + 1), out);
+            return;
+        }
+    }
+    for (IntType& value : out) {
+        value = this->operator()(gen);
+    }
+}
+
+// UniformIntDistribution over the compile-time range [kA, kB]. The reduction is chosen at
+// compile time, so a call compiles to a few instructions: a shift for power-of-two ranges,
+// which never reject, and Lemire's multiply-shift with a constant threshold otherwise.
+// Produces the same values as UniformIntDistribution{kA, kB} for the same engine state.
+//
+//     static constexpr FixedUniformIntDistribution<0, 9> kDigit;
+//     const int digit = kDigit(gen);
+template <auto kA, auto kB>
+class FixedUniformIntDistribution {
+    using IntType = decltype(kA);
+    using UType = std::make_unsigned_t<IntType>;
+
+    static_assert(std::is_integral_v<IntType>, "bounds must be integers");
+    static_assert(std::is_same_v<IntType, decltype(kB)>, "bounds must have the same type");
+    static_assert(kA <= kB, "empty range");
+
+    // Number of values minus one; fits in 64 bits even for the full range.
+    static constexpr uint64_t kURange = static_cast<UType>(kB) - static_cast<UType>(kA);
+
+   public:
+    using result_type = IntType;  // NOLINT(readability-identifier-naming)
+
+    template <class Gen>
+    constexpr IntType operator()(Gen& gen) const {
+        constexpr bool kWords32 =
+            Gen::min() == 0 && Gen::max() == std::numeric_limits<uint32_t>::max();
+        constexpr bool kWords64 =
+            Gen::min() == 0 && Gen::max() == std::numeric_limits<uint64_t>::max();
+        if constexpr (kURange == 0) {
+            return kA;
+        } else if constexpr (kWords32 && kURange <= std::numeric_limits<uint32_t>::max()) {
+            return Reduce<uint64_t, uint32_t>(gen);
+        } else if constexpr (kWords64) {
+            return __extension__ Reduce<unsigned __int128, uint64_t>(gen);
+        } else {
+            return UniformIntDistribution<IntType>{kA, kB}(gen);
+        }
+    }
+
+    template <class Gen>
+    void Fill(Gen& gen, std::span<IntType> out) const {
+        UniformIntDistribution<IntType>{kA, kB}.Fill(gen, out);
+    }
+
+    static constexpr IntType min() {  // NOLINT(readability-identifier-naming)
+        return kA;
+    }
+
+    static constexpr IntType max() {  // NOLINT(readability-identifier-naming)
+        return kB;
+    }
+
+   private:
+    template <class Wp, class Up, class Gen>
+    static constexpr IntType Reduce(Gen& gen) {
+        constexpr int kDigits = std::numeric_limits<Up>::digits;
+        if constexpr (kURange == std::numeric_limits<Up>::max()) {
+            return static_cast<IntType>(static_cast<UType>(kA) + static_cast<Up>(gen()));
+        } else if constexpr (((kURange + 1) & kURange) == 0) {
+            // x * 2^k >> digits, which is what the multiply-shift below computes; the low half
+            // is a multiple of 2^k and the threshold is zero, so nothing is rejected.
+            constexpr int kShift = kDigits - std::countr_zero(kURange + 1);
+            return static_cast<IntType>(
+                static_cast<UType>(kA) + static_cast<UType>(static_cast<Up>(gen()) >> kShift));
+        } else {
+            constexpr Up kRange = kURange + 1;
+            constexpr Up kThreshold = static_cast<Up>(-kRange) % kRange;
+            Wp product = static_cast<Wp>(static_cast<Up>(gen())) * kRange;
+            while (static_cast<Up>(product) < kThreshold) {
+                product = static_cast<Wp>(static_cast<Up>(gen())) * kRange;
+            }
+            return static_cast<IntType>(
+                static_cast<UType>(kA) + static_cast<UType>(product >> kDigits));
+        }
+    }
+};
+
 template <class RealType = double>
 class UniformRealDistribution {
    public:
     static_assert(std::is_floating_point_v<RealType>, "result_type must be a floating point type");
 
-    UniformRealDistribution() : UniformRealDistribution(0.) {
+    constexpr UniformRealDistribution() : UniformRealDistribution(0.) {
     }
 
-    explicit UniformRealDistribution(RealType a, RealType b = RealType{1}) : a_{a}, b_{b} {
+    explicit constexpr UniformRealDistribution(RealType a, RealType b = RealType{1})
+        : a_{a}, b_{b} {
     }
 
-    RealType operator()(auto& urng) {
+    RealType operator()(auto& urng) const {
         return GenerateCanonical(urng) * (b_ - a_) + a_;
     }
 
+    // Fills out with values of the same distribution as operator(), though not the same
+    // sequence: for float and double each value takes one word of random bits as its
+    // mantissa, which yields multiples of 2^-52 (2^-23 for float) instead of operator()'s
+    // 2^-64. The conversion runs in a branch-free loop over blocks of words the compiler can
+    // vectorize.
+    template <class Gen>
+    void Fill(Gen& gen, std::span<RealType> out) const {
+        constexpr bool kFullRange =
+            Gen::min() == 0 && (Gen::max() == std::numeric_limits<uint32_t>::max() ||
+                                Gen::max() == std::numeric_limits<uint64_t>::max());
+        constexpr bool kIeee = std::is_same_v<RealType, double> || std::is_same_v<RealType, float>;
+        if constexpr (kFullRange && kIeee) {
+            using Bits = std::conditional_t<std::is_same_v<RealType, double>, uint64_t, uint32_t>;
+            constexpr int kShift =
+                std::numeric_limits<Bits>::digits - std::numeric_limits<RealType>::digits + 1;
+            constexpr Bits kOne = std::bit_cast<Bits>(RealType{1});
+            constexpr size_t kBlock = 256;
+            std::array<Bits, kBlock> bits;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+            const RealType scale = b_ - a_;
+            while (!out.empty()) {
+                const size_t count = std::min(kBlock, out.size());
+                FillRandomBits(gen, std::span<Bits>(bits.data(), count));
+                for (size_t i = 0; i < count; ++i) {
+                    const RealType canonical =
+                        std::bit_cast<RealType>((bits[i] >> kShift) | kOne) - RealType{1};
+                    out[i] = canonical * scale + a_;
+                }
+                out = out.subspan(count);
+            }
+        } else {
+            for (RealType& value : out) {
+                value = this->operator()(gen);
+            }
+        }
+    }
+
    private:
     template <class Gen>
     static RealType GenerateCanonical(Gen& urng) {
-        constexpr auto kBits = std::numeric_limits<RealType>::digits;
-        constexpr auto kR =
-            static_cast<long double>(Gen::max()) - static_cast<long double>(Gen::min()) + 1.L;
-        const size_t log2r = std::log(kR) / std::log(2.L);
-        const size_t m = std::max<size_t>(1UL, (kBits + log2r - 1UL) / log2r);
-        RealType sum{0};
-        RealType tmp{1};
-        for (auto k = m; k != 0; --k) {
-            sum += static_cast<RealType>(urng() - urng.min()) * tmp;
-            tmp *= kR;
+        using Range = std::common_type_t<typename Gen::result_type, uint64_t>;
+        constexpr size_t kBits = std::numeric_limits<RealType>::digits;
+        constexpr Range kRange = Range{Gen::max()} - Range{Gen::min()};
+        constexpr auto kR = static_cast<long double>(kRange) + 1.L;
+        // floor(log2(kR)), the number of random bits per engine call.
+        constexpr size_t kLog2R = kRange == std::numeric_limits<Range>::max()
+                                      ? std::numeric_limits<Range>::digits
+                                      : std::bit_width(kRange + 1) - 1;
+        constexpr size_t kCalls = std::max<size_t>(1UL, (kBits + kLog2R - 1UL) / kLog2R);
+        if constexpr (Gen::min() == 0 && (kLog2R == 32 || kLog2R == 64) &&
+                      kRange == (Range{1} << (kLog2R - 1) << 1) - 1 && kCalls * kLog2R <= 64) {
+            // The words concatenated into one integer: the loop below adds them exactly except
+            // for the last addition, so a single conversion rounds the same way.
+            uint64_t bits = 0;
+            for (size_t k = 0; k < kCalls; ++k) {
+                bits |= static_cast<uint64_t>(urng()) << (k * kLog2R);
+            }
+            constexpr RealType kScale = RealType{1} / Power(static_cast<RealType>(kR), kCalls);
+            const RealType ret = static_cast<RealType>(bits) * kScale;
+            if (ret >= RealType{1}) {
+                return std::nextafter(RealType{1}, RealType{0});
+            }
+            return ret;
+        } else {
+            RealType sum{0};
+            RealType tmp{1};
+            for (auto k = kCalls; k != 0; --k) {
+                sum += static_cast<RealType>(urng() - urng.min()) * tmp;
+                tmp *= kR;
+            }
+            RealType ret = sum / tmp;
+            if (ret >= RealType{1}) {
+                return std::nextafter(RealType{1}, RealType{0});
+            }
+            return ret;
         }
-        RealType ret = sum / tmp;
-        if (ret >= RealType{1}) {
-            return std::nextafter(RealType{1}, RealType{0});
+    }
+
+    static constexpr RealType Power(RealType base, size_t exponent) {
+        RealType result{1};
+        for (; exponent != 0; --exponent) {
+            result *= base;
         }
-        return ret;
+        return result;
     }
 
     RealType a_;
     RealType b_;
 };
+
+// Helpers for the distributions below, which consume whole 64-bit words from any engine.
+namespace dist_detail {
+template <class Gen>
+uint64_t RandomWord(Gen& gen) {
+    if constexpr (Gen::min() == 0 && Gen::max() == std::numeric_limits<uint64_t>::max()) {
+        return gen();
+    } else {
+        return UniformIntDistribution<uint64_t>{0}(gen);
+    }
+}
+
+template <class Gen>
+void FillRandomWords(Gen& gen, std::span<uint64_t> out) {
+    if constexpr (Gen::min() == 0 && (Gen::max() == std::numeric_limits<uint32_t>::max() ||
+                                      Gen::max() == std::numeric_limits<uint64_t>::max())) {
+        FillRandomBits(gen, out);
+    } else {
+        for (uint64_t& word : out) {
+            word = RandomWord(gen);
+        }
+    }
+}
+
+// [0, 1) from bits 12..63; the low bits stay free for a ziggurat layer index.
+inline double ToUnit(uint64_t bits) {
+    return std::bit_cast<double>((bits >> 12) | 0x3ff0000000000000) - 1.;
+}
+
+// (0, 1), for taking logarithms.
+inline double ToOpenUnit(uint64_t bits) {
+    return (static_cast<double>(bits >> 11) + .5) * 0x1p-53;
+}
+
+// 256-layer ziggurat for a decreasing density f on [0, inf) with its tail starting at x[1],
+// laid out as in Doornik's ZIGNOR: layer i spans [0, x[i]) with f between f[i] and f[i + 1];
+// x[0] is the width of the base layer including the tail, and x[256] is 0.
+struct Ziggurat {
+    std::array<double, 257> x;
+    std::array<double, 257> f;
+};
+
+// r is the tail start and v the area of every layer.
+inline Ziggurat MakeZiggurat(double r, double v, double (*f)(double), double (*f_inv)(double)) {
+    Ziggurat table{};
+    table.x[0] = v / f(r);
+    table.x[1] = r;
+    for (size_t i = 2; i < 256; ++i) {
+        table.x[i] = f_inv(v / table.x[i - 1] + f(table.x[i - 1]));
+    }
+    table.x[256] = 0.;
+    for (size_t i = 0; i < table.x.size(); ++i) {
+        table.f[i] = f(table.x[i]);
+    }
+    return table;
+}
+
+inline constexpr double kNormalR = 3.6541528853610088;
+inline constexpr double kExponentialR = 7.69711747013104972;
+
+inline const Ziggurat& NormalZiggurat() {
+    static const Ziggurat kTable = MakeZiggurat(
+        kNormalR, 0.00492867323399, [](double x) { return std::exp(-.5 * x * x); },
+        [](double y) { return std::sqrt(-2. * std::log(y)); });
+    return kTable;
+}
+
+inline const Ziggurat& ExponentialZiggurat() {
+    static const Ziggurat kTable = MakeZiggurat(
+        kExponentialR, 0.0039496598225815571993, [](double x) { return std::exp(-x); },
+        [](double y) { return -std::log(y); });
+    return kTable;
+}
+}  // namespace dist_detail
+
+// Gaussian distribution sampled with a 256-layer ziggurat (Marsaglia and Tsang). About 99% of
+// draws take one 64-bit word, a table lookup and a multiply; the rest fall back to the wedge
+// and tail tests. Unlike std::normal_distribution, the sequence is the same with every
+// standard library.
+template <class RealType = double>
+class NormalDistribution {
+    static_assert(std::is_floating_point_v<RealType>, "result_type must be a floating point type");
+
+   public:
+    constexpr NormalDistribution() : NormalDistribution(0.) {
+    }
+
+    explicit constexpr NormalDistribution(RealType mean, RealType stddev = RealType{1})
+        : mean_{mean}, stddev_{stddev} {
+    }
+
+    template <class Gen>
+    RealType operator()(Gen& gen) const {
+        return Scale(Standard(gen, dist_detail::RandomWord(gen)));
+    }
+
+    // Same distribution as operator(), though not the same sequence: words come off the
+    // engine a block at a time, the common case is decided in a branch-free loop, and the
+    // rest go through the wedge and tail tests in a second pass.
+    template <class Gen>
+    void Fill(Gen& gen, std::span<RealType> out) const {
+        constexpr size_t kBlock = 256;
+        const auto& table = dist_detail::NormalZiggurat();
+        std::array<uint64_t, kBlock> words;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        while (!out.empty()) {
+            const size_t count = std::min(kBlock, out.size());
+            dist_detail::FillRandomWords(gen, std::span<uint64_t>(words.data(), count));
+            std::array<bool, kBlock> accepted;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+            size_t rejected = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const size_t layer = words[i] & 0xff;
+                const double x = (2. * dist_detail::ToUnit(words[i]) - 1.) * table.x[layer];
+                accepted[i] = std::abs(x) < table.x[layer + 1];
+                rejected += accepted[i] ? 0 : 1;
+                out[i] = Scale(x);
+            }
+            for (size_t i = 0; rejected != 0; ++i) {
+                if (!accepted[i]) {
+                    out[i] = Scale(Standard(gen, words[i]));
+                    --rejected;
+                }
+            }
+            out = out.subspan(count);
+        }
+    }
+
+   private:
+    RealType Scale(double x) const {
+        return mean_ + stddev_ * static_cast<RealType>(x);
+    }
+
+    // A standard normal value, starting from the proposal in bits.
+    template <class Gen>
+    static double Standard(Gen& gen, uint64_t bits) {
+        const auto& table = dist_detail::NormalZiggurat();
+        for (;;) {
+            const size_t layer = bits & 0xff;
+            const double u = 2. * dist_detail::ToUnit(bits) - 1.;
+            const double x = u * table.x[layer];
+            if (std::abs(x) < table.x[layer + 1]) {
+                return x;
+            }
+            if (layer == 0) {
+                return Tail(gen, u < 0.);
+            }
+            const double wedge = dist_detail::ToUnit(dist_detail::RandomWord(gen));
+            const double f = table.f[layer + 1] + (table.f[layer] - table.f[layer + 1]) * wedge;
+            if (f < std::exp(-.5 * x * x)) {
+                return x;
+            }
+            bits = dist_detail::RandomWord(gen);
+        }
+    }
+
+    // Marsaglia's method for the tail beyond kNormalR.
+    template <class Gen>
+    static double Tail(Gen& gen, bool negative) {
+        double x = 0.;
+        double y = 0.;
+        do {  // NOLINT(cppcoreguidelines-avoid-do-while)
+            x = std::log(dist_detail::ToOpenUnit(dist_detail::RandomWord(gen))) /
+                dist_detail::kNormalR;
+            y = std::log(dist_detail::ToOpenUnit(dist_detail::RandomWord(gen)));
+        } while (-2. * y < x * x);
+        return negative ? x - dist_detail::kNormalR : dist_detail::kNormalR - x;
+    }
+
+    RealType mean_;
+    RealType stddev_;
+};
+
+// Exponential distribution with the given rate, sampled with a 256-layer ziggurat.
+template <class RealType = double>
+class ExponentialDistribution {
+    static_assert(std::is_floating_point_v<RealType>, "result_type must be a floating point type");
+
+   public:
+    constexpr ExponentialDistribution() : ExponentialDistribution(1.) {
+    }
+
+    explicit constexpr ExponentialDistribution(RealType lambda) : lambda_{lambda} {
+    }
+
+    template <class Gen>
+    RealType operator()(Gen& gen) const {
+        return Scale(Standard(gen, dist_detail::RandomWord(gen)));
+    }
+
+    // Same structure as NormalDistribution::Fill.
+    template <class Gen>
+    void Fill(Gen& gen, std::span<RealType> out) const {
+        constexpr size_t kBlock = 256;
+        const auto& table = dist_detail::ExponentialZiggurat();
+        std::array<uint64_t, kBlock> words;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        while (!out.empty()) {
+            const size_t count = std::min(kBlock, out.size());
+            dist_detail::FillRandomWords(gen, std::span<uint64_t>(words.data(), count));
+            std::array<bool, kBlock> accepted;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+            size_t rejected = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const size_t layer = words[i] & 0xff;
+                const double x = dist_detail::ToUnit(words[i]) * table.x[layer];
+                accepted[i] = x < table.x[layer + 1];
+                rejected += accepted[i] ? 0 : 1;
+                out[i] = Scale(x);
+            }
+            for (size_t i = 0; rejected != 0; ++i) {
+                if (!accepted[i]) {
+                    out[i] = Scale(Standard(gen, words[i]));
+                    --rejected;
+                }
+            }
+            out = out.subspan(count);
+        }
+    }
+
+   private:
+    RealType Scale(double x) const {
+        return static_cast<RealType>(x) / lambda_;
+    }
+
+    template <class Gen>
+    static double Standard(Gen& gen, uint64_t bits) {
+        const auto& table = dist_detail::ExponentialZiggurat();
+        for (;;) {
+            const size_t layer = bits & 0xff;
+            const double x = dist_detail::ToUnit(bits) * table.x[layer];
+            if (x < table.x[layer + 1]) {
+                return x;
+            }
+            if (layer == 0) {
+                // The tail of an exponential is a shifted exponential.
+                return dist_detail::kExponentialR -
+                       std::log(dist_detail::ToOpenUnit(dist_detail::RandomWord(gen)));
+            }
+            const double wedge = dist_detail::ToUnit(dist_detail::RandomWord(gen));
+            const double f = table.f[layer + 1] + (table.f[layer] - table.f[layer + 1]) * wedge;
+            if (f < std::exp(-x)) {
+                return x;
+            }
+            bits = dist_detail::RandomWord(gen);
+        }
+    }
+
+    RealType lambda_;
+};
+
+// Zipf distribution on [1, n]: P(k) is proportional to k^-exponent, for any exponent > 0.
+// Sampled by rejection-inversion (Hoermann and Derflinger), which needs no tables, so n can
+// be huge; each draw costs about one proposal.
+template <class IntType = int64_t>
+class ZipfDistribution {
+    static_assert(std::is_integral_v<IntType>, "template argument must be an integral type");
+
+   public:
+    ZipfDistribution(IntType n, double exponent)
+        : n_{n}
+        , exponent_{exponent}
+        , h_integral_x1_{HIntegral(1.5) - 1.}
+        , h_integral_n_{HIntegral(static_cast<double>(n) + .5)}
+        , s_{2. - HIntegralInverse(HIntegral(2.5) - H(2.))} {
+        if (n < 1 || !(exponent > 0.)) {
+            throw std::invalid_argument{"ZipfDistribution needs n >= 1 and exponent > 0"};
+        }
+    }
+
+    template <class Gen>
+    IntType operator()(Gen& gen) const {
+        for (;;) {
+            if (const auto k = Propose(dist_detail::RandomWord(gen))) {
+                return *k;
+            }
+        }
+    }
+
+    // Proposals for a block are made in one loop; rejected slots are redrawn afterwards.
+    template <class Gen>
+    void Fill(Gen& gen, std::span<IntType> out) const {
+        constexpr size_t kBlock = 256;
+        std::array<uint64_t, kBlock> words;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        std::array<bool, kBlock> accepted;   // NOLINT(cppcoreguidelines-pro-type-member-init)
+        while (!out.empty()) {
+            const size_t count = std::min(kBlock, out.size());
+            dist_detail::FillRandomWords(gen, std::span<uint64_t>(words.data(), count));
+            for (size_t i = 0; i < count; ++i) {
+                const auto k = Propose(words[i]);
+                accepted[i] = k.has_value();
+                out[i] = k.value_or(IntType{1});
+            }
+            for (size_t i = 0; i < count; ++i) {
+                if (!accepted[i]) {
+                    out[i] = this->operator()(gen);
+                }
+            }
+            out = out.subspan(count);
+        }
+    }
+
+   private:
+    // k if the proposal made from bits is accepted.
+    [[nodiscard]] std::optional<IntType> Propose(uint64_t bits) const {
+        const double u =
+            h_integral_n_ + dist_detail::ToUnit(bits) * (h_integral_x1_ - h_integral_n_);
+        const double x = HIntegralInverse(u);
+        const auto k = static_cast<IntType>(std::clamp(x + .5, 1., static_cast<double>(n_)));
+        const auto kd = static_cast<double>(k);
+        if (kd - x <= s_ || u >= HIntegral(kd + .5) - H(kd)) {
+            return k;
+        }
+        return std::nullopt;
+    }
+
+    // H is an integral of h(x) = x^-exponent, written to stay accurate near exponent == 1.
+    [[nodiscard]] double HIntegral(double x) const {
+        const double log_x = std::log(x);
+        return Helper2((1. - exponent_) * log_x) * log_x;
+    }
+
+    [[nodiscard]] double H(double x) const {
+        return std::exp(-exponent_ * std::log(x));
+    }
+
+    [[nodiscard]] double HIntegralInverse(double x) const {
+        const double t = std::max(-1., x * (1. - exponent_));
+        return std::exp(Helper1(t) * x);
+    }
+
+    // log1p(x) / x
+    static double Helper1(double x) {
+        if (std::abs(x) > 1e-8) {
+            return std::log1p(x) / x;
+        }
+        return 1. - x * (.5 - x * (1. / 3. - .25 * x));
+    }
+
+    // expm1(x) / x
+    static double Helper2(double x) {
+        if (std::abs(x) > 1e-8) {
+            return std::expm1(x) / x;
+        }
+        return 1. + x * .5 * (1. + x / 3. * (1. + .25 * x));
+    }
+
+    IntType n_;
+    double exponent_;
+    double h_integral_x1_;
+    double h_integral_n_;
+    double s_;
+};
+
+// Distribution on [0, weights.size()) with P(i) proportional to weights[i], sampled in O(1)
+// with Vose's alias method: one uniform column and one biased coin per draw.
+template <class IntType = int>
+class DiscreteDistribution {
+    static_assert(std::is_integral_v<IntType>, "template argument must be an integral type");
+
+   public:
+    explicit DiscreteDistribution(std::span<const double> weights)
+        : column_{0, static_cast<IntType>(weights.size()) - 1}
+        , threshold_(weights.size())
+        , alias_(weights.size()) {
+        double sum = 0.;
+        for (const double weight : weights) {
+            if (!(weight >= 0.) || !std::isfinite(weight)) {
+                throw std::invalid_argument{"DiscreteDistribution weights must be finite, >= 0"};
+            }
+            sum += weight;
+        }
+        if (weights.empty() || !(sum > 0.)) {
+            throw std::invalid_argument{"DiscreteDistribution needs a positive total weight"};
+        }
+        const auto n = static_cast<double>(weights.size());
+        std::vector<double> scaled(weights.size());
+        std::vector<IntType> small;
+        std::vector<IntType> large;
+        for (size_t i = 0; i < weights.size(); ++i) {
+            scaled[i] = weights[i] * n / sum;
+            (scaled[i] < 1. ? small : large).push_back(static_cast<IntType>(i));
+        }
+        while (!small.empty() && !large.empty()) {
+            const IntType less = small.back();
+            small.pop_back();
+            const IntType more = large.back();
+            large.pop_back();
+            threshold_[less] = Threshold(scaled[less]);
+            alias_[less] = more;
+            scaled[more] = (scaled[more] + scaled[less]) - 1.;
+            (scaled[more] < 1. ? small : large).push_back(more);
+        }
+        // Whatever is left is 1 up to rounding.
+        for (const auto& rest : {small, large}) {
+            for (const IntType i : rest) {
+                threshold_[i] = kAlways;
+                alias_[i] = i;
+            }
+        }
+    }
+
+    DiscreteDistribution(std::initializer_list<double> weights)
+        : DiscreteDistribution(std::span<const double>(weights.begin(), weights.size())) {
+    }
+
+    template <class Gen>
+    IntType operator()(Gen& gen) const {
+        return Pick(column_(gen), dist_detail::RandomWord(gen));
+    }
+
+    // Columns are drawn with UniformIntDistribution::Fill, then resolved against the coins in
+    // one branch-free loop.
+    template <class Gen>
+    void Fill(Gen& gen, std::span<IntType> out) const {
+        constexpr size_t kBlock = 256;
+        std::array<uint64_t, kBlock> coins;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        column_.Fill(gen, out);
+        while (!out.empty()) {
+            const size_t count = std::min(kBlock, out.size());
+            dist_detail::FillRandomWords(gen, std::span<uint64_t>(coins.data(), count));
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = Pick(out[i], coins[i]);
+            }
+            out = out.subspan(count);
+        }
+    }
+
+   private:
+    // Coins are compared as 53-bit integers, so a probability of 1 always keeps the column.
+    static constexpr uint64_t kAlways = uint64_t{1} << 53;
+
+    static uint64_t Threshold(double probability) {
+        return static_cast<uint64_t>(std::clamp(probability, 0., 1.) * 0x1p53);
+    }
+
+    IntType Pick(IntType column, uint64_t coin) const {
+        const auto index = static_cast<size_t>(column);
+        return (coin >> 11) < threshold_[index] ? column : alias_[index];
+    }
+
+    UniformIntDistribution<IntType> column_;
+    std::vector<uint64_t> threshold_;
+    std::vector<IntType> alias_;
+};
@@ -0,0 +1,342 @@
+#include "dist.h"
+#include "engines.h"
+
+#include <catch2/catch_template_test_macros.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace {
+constexpr size_t kSamples = size_t{1} << 20;
+
+// Pearson's statistic of the counts against the probabilities of their buckets, and whether it
+// is within six standard deviations of its mean. Buckets of probability zero must stay empty.
+// The seeds are fixed, so this is a regression check, not a flaky one.
+bool Fits(const std::vector<int64_t>& counts, const std::vector<double>& probabilities) {
+    int64_t total = 0;
+    for (const int64_t count : counts) {
+        total += count;
+    }
+    double chi_square = 0.;
+    size_t buckets = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (probabilities[i] == 0.) {
+            if (counts[i] != 0) {
+                return false;
+            }
+            continue;
+        }
+        const double expected = probabilities[i] * static_cast<double>(total);
+        const double delta = static_cast<double>(counts[i]) - expected;
+        chi_square += delta * delta / expected;
+        ++buckets;
+    }
+    const auto freedom = static_cast<double>(buckets - 1);
+    CAPTURE(chi_square, freedom);
+    return chi_square < freedom + 6. * std::sqrt(2. * freedom);
+}
+
+bool IsUniform(const std::vector<int64_t>& counts) {
+    const double probability = 1. / static_cast<double>(counts.size());
+    return Fits(counts, std::vector<double>(counts.size(), probability));
+}
+
+// UniformRealDistribution's operator() as it was before the single-conversion fast path, which
+// must not change the sequence.
+template <class RealType, class Gen>
+RealType ReferenceCanonical(Gen& urng) {
+    constexpr auto kBits = std::numeric_limits<RealType>::digits;
+    constexpr auto kR =
+        static_cast<long double>(Gen::max()) - static_cast<long double>(Gen::min()) + 1.L;
+    const size_t log2r = std::log(kR) / std::log(2.L);
+    const size_t m = std::max<size_t>(1UL, (kBits + log2r - 1UL) / log2r);
+    RealType sum{0};
+    RealType tmp{1};
+    for (auto k = m; k != 0; --k) {
+        sum += static_cast<RealType>(urng() - urng.min()) * tmp;
+        tmp *= kR;
+    }
+    RealType ret = sum / tmp;
+    if (ret >= RealType{1}) {
+        return std::nextafter(RealType{1}, RealType{0});
+    }
+    return ret;
+}
+
+template <auto kA, auto kB, class Gen>
+void CheckFixedMatchesDynamic() {
+    using IntType = decltype(kA);
+    constexpr FixedUniformIntDistribution<kA, kB> kFixed;
+    const UniformIntDistribution<IntType> dynamic{kA, kB};
+    Gen gen{9};
+    Gen reference = gen;
+    for (int i = 0; i < 100000; ++i) {
+        const IntType expected = dynamic(reference);
+        CAPTURE(i);
+        REQUIRE(kFixed(gen) == expected);
+    }
+
+    std::vector<IntType> fixed_values(1000);
+    std::vector<IntType> dynamic_values(fixed_values.size());
+    kFixed.Fill(gen, std::span<IntType>(fixed_values));
+    dynamic.Fill(reference, std::span<IntType>(dynamic_values));
+    CHECK(fixed_values == dynamic_values);
+    CHECK(gen() == reference());
+}
+
+template <class RealType, class Gen>
+void CheckRealSequence(RealType a, RealType b) {
+    using Bits = std::conditional_t<std::is_same_v<RealType, float>, uint32_t, uint64_t>;
+    Gen gen{3};
+    Gen reference = gen;
+    const UniformRealDistribution<RealType> dist{a, b};
+    for (int i = 0; i < 100000; ++i) {
+        const RealType expected = ReferenceCanonical<RealType>(reference) * (b - a) + a;
+        const RealType actual = dist(gen);
+        CAPTURE(i, expected, actual);
+        REQUIRE(std::bit_cast<Bits>(actual) == std::bit_cast<Bits>(expected));
+    }
+}
+
+// Sample mean and variance within six standard errors of the given ones; the error of the
+// variance assumes a kurtosis of at most 9, which covers the normal and exponential cases.
+void CheckMoments(std::span<const double> values, double mean, double variance) {
+    double sum = 0.;
+    for (const double value : values) {
+        sum += value;
+    }
+    const auto n = static_cast<double>(values.size());
+    const double sample_mean = sum / n;
+    double squares = 0.;
+    for (const double value : values) {
+        squares += (value - sample_mean) * (value - sample_mean);
+    }
+    const double sample_variance = squares / (n - 1.);
+    CAPTURE(sample_mean, sample_variance);
+    CHECK(std::abs(sample_mean - mean) < 6. * std::sqrt(variance / n));
+    CHECK(std::abs(sample_variance - variance) < 6. * variance * std::sqrt(8. / n));
+}
+
+template <class Dist, class Gen>
+std::vector<double> Draw(const Dist& dist, Gen& gen) {
+    std::vector<double> values(kSamples);
+    for (double& value : values) {
+        value = dist(gen);
+    }
+    return values;
+}
+
+template <class Dist, class Gen>
+std::vector<double> DrawFill(const Dist& dist, Gen& gen) {
+    std::vector<double> values(kSamples);
+    dist.Fill(gen, std::span<double>(values));
+    return values;
+}
+
+// Counts of the values 1..n (Zipf) or 0..n-1 (discrete), by operator() or by Fill.
+template <class IntType, class Dist, class Gen>
+std::vector<int64_t> Count(const Dist& dist, Gen& gen, size_t n, IntType first, bool fill) {
+    std::vector<IntType> values(kSamples);
+    if (fill) {
+        dist.Fill(gen, std::span<IntType>(values));
+    } else {
+        for (IntType& value : values) {
+            value = dist(gen);
+        }
+    }
+    std::vector<int64_t> counts(n);
+    for (const IntType value : values) {
+        REQUIRE(value >= first);
+        REQUIRE(value < first + static_cast<IntType>(n));
+        ++counts[static_cast<size_t>(value - first)];
+    }
+    return counts;
+}
+
+template <class RealType, class Gen>
+void CheckRealFill(RealType a, RealType b) {
+    Gen gen{5};
+    const UniformRealDistribution<RealType> dist{a, b};
+    std::vector<RealType> values(kSamples);
+    dist.Fill(gen, std::span<RealType>(values));
+    constexpr size_t kBuckets = 64;
+    std::vector<int64_t> counts(kBuckets);
+    for (const RealType value : values) {
+        REQUIRE(value >= a);
+        REQUIRE(value < b);
+        ++counts[std::min(static_cast<size_t>((value - a) / (b - a) * kBuckets), kBuckets - 1)];
+    }
+    CHECK(IsUniform(counts));
+}
+}  // namespace
+
+TEMPLATE_TEST_CASE(
+    "UniformIntDistribution::Fill covers a small range uniformly", "", std::mt19937, Philox4x32,
+    Xoshiro256StarStar, Xoshiro256StarStarLanes<>) {
+    TestType gen{7};
+    const UniformIntDistribution<int> dist{-3, 7};
+    std::vector<int> values(kSamples);
+    dist.Fill(gen, std::span<int>(values));
+    std::vector<int64_t> counts(11);
+    for (const int value : values) {
+        REQUIRE(value >= -3);
+        REQUIRE(value <= 7);
+        ++counts[value + 3];
+    }
+    CHECK(IsUniform(counts));
+}
+
+TEMPLATE_TEST_CASE(
+    "UniformIntDistribution::Fill stays uniform when most words are rejected", "", std::mt19937,
+    Philox4x32, Xoshiro256StarStar, Xoshiro256StarStarLanes<>) {
+    TestType gen{11};
+    constexpr size_t kBuckets = 64;
+
+    SECTION("32-bit reduction") {
+        // 2^32 mod (2^31 + 1) = 2^31 - 1: about half the words land under the threshold and
+        // are redrawn in the second pass.
+        constexpr int64_t kMax = int64_t{1} << 31;
+        const UniformIntDistribution<int64_t> dist{0, kMax};
+        std::vector<int64_t> values(kSamples);
+        dist.Fill(gen, std::span<int64_t>(values));
+        std::vector<int64_t> counts(kBuckets);
+        for (const int64_t value : values) {
+            REQUIRE(value >= 0);
+            REQUIRE(value <= kMax);
+            ++counts[static_cast<size_t>(value) * kBuckets / (kMax + 1)];
+        }
+        CHECK(IsUniform(counts));
+    }
+
+    SECTION("64-bit reduction") {
+        // Same for 2^64 mod (2^63 + 1); 32-bit engines take the operator() path.
+        constexpr uint64_t kMax = uint64_t{1} << 63;
+        const UniformIntDistribution<uint64_t> dist{0, kMax};
+        std::vector<uint64_t> values(kSamples);
+        dist.Fill(gen, std::span<uint64_t>(values));
+        std::vector<int64_t> counts(kBuckets);
+        for (const uint64_t value : values) {
+            REQUIRE(value <= kMax);
+            ++counts[std::min<uint64_t>(value >> 57, kBuckets - 1)];
+        }
+        CHECK(IsUniform(counts));
+    }
+}
+
+TEMPLATE_TEST_CASE(
+    "FixedUniformIntDistribution matches UniformIntDistribution", "", std::mt19937,
+    Xoshiro256StarStar) {
+    // Power of two.
+    CheckFixedMatchesDynamic<0, 15, TestType>();
+    CheckFixedMatchesDynamic<0, 9, TestType>();
+    CheckFixedMatchesDynamic<-3, 99, TestType>();
+    CheckFixedMatchesDynamic<uint32_t{0}, std::numeric_limits<uint32_t>::max(), TestType>();
+    // Wider than the words of a 32-bit engine.
+    CheckFixedMatchesDynamic<int64_t{0}, int64_t{1'000'000'000'000}, TestType>();
+    CheckFixedMatchesDynamic<std::numeric_limits<int64_t>::min(),
+                             std::numeric_limits<int64_t>::max(), TestType>();
+}
+
+TEMPLATE_TEST_CASE(
+    "UniformRealDistribution's operator() keeps its sequence", "", std::mt19937, std::mt19937_64,
+    std::minstd_rand, Philox4x32, Xoshiro256StarStar) {
+    CheckRealSequence<double, TestType>(0., 1.);
+    CheckRealSequence<double, TestType>(-2.5, 1e3);
+    CheckRealSequence<float, TestType>(0.F, 1.F);
+    CheckRealSequence<float, TestType>(-2.5F, 1e3F);
+}
+
+TEMPLATE_TEST_CASE(
+    "UniformRealDistribution::Fill covers the range uniformly", "", std::mt19937,
+    std::minstd_rand, Philox4x32, Xoshiro256StarStar, Xoshiro256StarStarLanes<>) {
+    CheckRealFill<double, TestType>(0., 1.);
+    CheckRealFill<double, TestType>(-2.5, 1e3);
+    CheckRealFill<float, TestType>(0.F, 1.F);
+    CheckRealFill<float, TestType>(-2.5F, 1e3F);
+}
+
+TEMPLATE_TEST_CASE(
+    "NormalDistribution has the right mean and variance", "", std::mt19937, std::minstd_rand,
+    Xoshiro256StarStar, Xoshiro256StarStarLanes<>) {
+    TestType gen{13};
+    const NormalDistribution<double> dist{3., 2.};
+    CheckMoments(Draw(dist, gen), 3., 4.);
+    CheckMoments(DrawFill(dist, gen), 3., 4.);
+}
+
+TEMPLATE_TEST_CASE(
+    "ExponentialDistribution has the right mean and variance", "", std::mt19937,
+    std::minstd_rand, Xoshiro256StarStar, Xoshiro256StarStarLanes<>) {
+    TestType gen{17};
+    const ExponentialDistribution<double> dist{.5};
+    CheckMoments(Draw(dist, gen), 2., 4.);
+    CheckMoments(DrawFill(dist, gen), 2., 4.);
+}
+
+TEMPLATE_TEST_CASE(
+    "ZipfDistribution follows k^-s", "", std::mt19937, std::minstd_rand, Xoshiro256StarStar,
+    Xoshiro256StarStarLanes<>) {
+    TestType gen{19};
+    constexpr size_t kN = 10;
+    // Both sides of exponent 1, where the integral changes form.
+    for (const double exponent : {.8, 1., 1.2}) {
+        std::vector<double> probabilities(kN);
+        double harmonic = 0.;
+        for (size_t k = 1; k <= kN; ++k) {
+            probabilities[k - 1] = std::pow(static_cast<double>(k), -exponent);
+            harmonic += probabilities[k - 1];
+        }
+        for (double& probability : probabilities) {
+            probability /= harmonic;
+        }
+        const ZipfDistribution<int64_t> dist{kN, exponent};
+        CAPTURE(exponent);
+        CHECK(Fits(Count<int64_t>(dist, gen, kN, 1, false), probabilities));
+        CHECK(Fits(Count<int64_t>(dist, gen, kN, 1, true), probabilities));
+    }
+}
+
+TEMPLATE_TEST_CASE(
+    "DiscreteDistribution follows its weights", "", std::mt19937, std::minstd_rand,
+    Xoshiro256StarStar, Xoshiro256StarStarLanes<>) {
+    TestType gen{23};
+    const std::vector<double> weights = {1., 0., 3., .5, 2.5, 0., 1e-3};
+    double total = 0.;
+    for (const double weight : weights) {
+        total += weight;
+    }
+    std::vector<double> probabilities;
+    for (const double weight : weights) {
+        probabilities.push_back(weight / total);
+    }
+    const DiscreteDistribution<int> dist{weights};
+    CHECK(Fits(Count<int>(dist, gen, weights.size(), 0, false), probabilities));
+    CHECK(Fits(Count<int>(dist, gen, weights.size(), 0, true), probabilities));
+}
+
+TEST_CASE("Distributions reject invalid parameters") {
+    constexpr double kInf = std::numeric_limits<double>::infinity();
+    constexpr double kNan = std::numeric_limits<double>::quiet_NaN();
+    CHECK_THROWS_AS(ZipfDistribution<int64_t>(0, 1.), std::invalid_argument);
+    CHECK_THROWS_AS(ZipfDistribution<int64_t>(-5, 1.), std::invalid_argument);
+    CHECK_THROWS_AS(ZipfDistribution<int64_t>(10, 0.), std::invalid_argument);
+    CHECK_THROWS_AS(ZipfDistribution<int64_t>(10, -1.), std::invalid_argument);
+    CHECK_THROWS_AS(ZipfDistribution<int64_t>(10, kNan), std::invalid_argument);
+    CHECK_NOTHROW(ZipfDistribution<int64_t>(1, 1.));
+
+    CHECK_THROWS_AS(DiscreteDistribution<int>(std::span<const double>{}), std::invalid_argument);
+    CHECK_THROWS_AS(DiscreteDistribution<int>({1., -1.}), std::invalid_argument);
+    CHECK_THROWS_AS(DiscreteDistribution<int>({1., kInf}), std::invalid_argument);
+    CHECK_THROWS_AS(DiscreteDistribution<int>({1., kNan}), std::invalid_argument);
+    CHECK_THROWS_AS(DiscreteDistribution<int>({0., 0.}), std::invalid_argument);
+    CHECK_NOTHROW(DiscreteDistribution<int>({0., 1.}));
+}
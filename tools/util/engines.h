@@ -0,0 +1,310 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+
+// Uniform random bit generators that are faster than std::mt19937 and keep a fraction of its
+// 2.5 KiB of state. All of them satisfy std::uniform_random_bit_generator and work with the
+// distributions in dist.h.
+
+// Sebastiano Vigna's SplitMix64. Used to expand a single seed into engine state; good enough
+// as a generator on its own, but with only 64 bits of state.
+class SplitMix64 {
+   public:
+    using result_type = uint64_t;  // NOLINT(readability-identifier-naming)
+
+    explicit constexpr SplitMix64(uint64_t seed) : state_{seed} {
+    }
+
+    constexpr uint64_t operator()() {
+        uint64_t z = (state_ += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr uint64_t min() {  // NOLINT(readability-identifier-naming)
+        return 0;
+    }
+
+    static constexpr uint64_t max() {  // NOLINT(readability-identifier-naming)
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+   private:
+    uint64_t state_;
+};
+
+// xoshiro256** by Blackman and Vigna, seeded through SplitMix64.
+class Xoshiro256StarStar {
+   public:
+    using result_type = uint64_t;  // NOLINT(readability-identifier-naming)
+
+    explicit constexpr Xoshiro256StarStar(uint64_t seed) {
+        SplitMix64 seeder{seed};
+        for (uint64_t& word : state_) {
+            word = seeder();
+        }
+    }
+
+    constexpr uint64_t operator()() {
+        const uint64_t result = std::rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = std::rotl(state_[3], 45);
+        return result;
+    }
+
+    // Advances the state by 2^128 steps; used to give threads or lanes non-overlapping
+    // subsequences of one seed.
+    constexpr void Jump() {
+        constexpr std::array<uint64_t, 4> kJump = {
+            0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+        std::array<uint64_t, 4> state{};
+        for (const uint64_t jump : kJump) {
+            for (int bit = 0; bit < 64; ++bit) {
+                if ((jump & (uint64_t{1} << bit)) != 0) {
+                    for (size_t i = 0; i < state.size(); ++i) {
+                        state[i] ^= state_[i];
+                    }
+                }
+                this->operator()();
+            }
+        }
+        state_ = state;
+    }
+
+    [[nodiscard]] constexpr const std::array<uint64_t, 4>& State() const {
+        return state_;
+    }
+
+    static constexpr uint64_t min() {  // NOLINT(readability-identifier-naming)
+        return 0;
+    }
+
+    static constexpr uint64_t max() {  // NOLINT(readability-identifier-naming)
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+   private:
+    std::array<uint64_t, 4> state_{};
+};
+
+// PCG64 (XSL RR 128/64) by O'Neill: a 128-bit LCG with a permuted 64-bit output. The stream
+// selects one of 2^64 independent sequences; the 128-bit increment has room for 2^127, but
+// the stream argument is a uint64_t.
+class Pcg64 {
+    __extension__ using Uint128 = unsigned __int128;
+
+   public:
+    using result_type = uint64_t;  // NOLINT(readability-identifier-naming)
+
+    explicit constexpr Pcg64(
+        uint64_t seed, uint64_t stream = 0)  // NOLINT(fuchsia-default-arguments-declarations)
+        : increment_{(Uint128{stream} << 1) | 1} {
+        SplitMix64 seeder{seed};
+        const Uint128 initial = (Uint128{seeder()} << 64) | seeder();
+        Step();
+        state_ += initial;
+        Step();
+    }
+
+    constexpr uint64_t operator()() {
+        Step();
+        const auto rotation = static_cast<int>(state_ >> 122);
+        return std::rotr(static_cast<uint64_t>(state_ >> 64) ^ static_cast<uint64_t>(state_),
+                         rotation);
+    }
+
+    static constexpr uint64_t min() {  // NOLINT(readability-identifier-naming)
+        return 0;
+    }
+
+    static constexpr uint64_t max() {  // NOLINT(readability-identifier-naming)
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+   private:
+    static constexpr Uint128 kMultiplier =
+        (Uint128{0x2360ed051fc65da4} << 64) | Uint128{0x4385df649fccf645};
+
+    constexpr void Step() {
+        state_ = state_ * kMultiplier + increment_;
+    }
+
+    Uint128 state_ = 0;
+    Uint128 increment_;
+};
+
+// kLanes interleaved xoshiro256** generators stored lane-major, so one step of all lanes is
+// a loop over plain arrays that compiles to SIMD shifts, xors and adds. Lane i starts i jumps
+// after a Xoshiro256StarStar with the same seed. Fill is the fast path; operator() hands out
+// the same sequence one word at a time.
+template <size_t kLanes = 16>
+class Xoshiro256StarStarLanes {
+   public:
+    using result_type = uint64_t;  // NOLINT(readability-identifier-naming)
+
+    explicit constexpr Xoshiro256StarStarLanes(uint64_t seed) {
+        Xoshiro256StarStar lane{seed};
+        for (size_t i = 0; i < kLanes; ++i) {
+            for (size_t word = 0; word < 4; ++word) {
+                state_[word][i] = lane.State()[word];
+            }
+            lane.Jump();
+        }
+    }
+
+    constexpr uint64_t operator()() {
+        if (next_ == kLanes) {
+            Step(buffer_.data());
+            next_ = 0;
+        }
+        return buffer_[next_++];
+    }
+
+    // Same words as out.size() calls of operator().
+    constexpr void Fill(std::span<uint64_t> out) {
+        while (next_ != kLanes && !out.empty()) {
+            out.front() = buffer_[next_++];
+            out = out.subspan(1);
+        }
+        for (; out.size() >= kLanes; out = out.subspan(kLanes)) {
+            Step(out.data());
+        }
+        for (uint64_t& word : out) {
+            word = this->operator()();
+        }
+    }
+
+    static constexpr uint64_t min() {  // NOLINT(readability-identifier-naming)
+        return 0;
+    }
+
+    static constexpr uint64_t max() {  // NOLINT(readability-identifier-naming)
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+   private:
+    constexpr void Step(uint64_t* out) {
+        auto& [s0, s1, s2, s3] = state_;
+        for (size_t i = 0; i < kLanes; ++i) {
+            out[i] = std::rotl(s1[i] * 5, 7) * 9;  // NOLINT(*-pointer-arithmetic)
+            const uint64_t t = s1[i] << 17;
+            s2[i] ^= s0[i];
+            s3[i] ^= s1[i];
+            s1[i] ^= s2[i];
+            s0[i] ^= s3[i];
+            s2[i] ^= t;
+            s3[i] = std::rotl(s3[i], 45);
+        }
+    }
+
+    std::array<std::array<uint64_t, kLanes>, 4> state_{};
+    std::array<uint64_t, kLanes> buffer_{};
+    size_t next_ = kLanes;
+};
+
+// Philox4x32-10 by Salmon et al. (Random123): word i of the sequence is a keyed bijection of
+// its index, so any word can be computed in O(1) with At(i), the position can be moved
+// anywhere with Seek, and disjoint index ranges can be filled from different threads with
+// no shared state. The seed is the key; the stream selects one of 2^64 independent
+// sequences.
+class Philox4x32 {
+    using Block = std::array<uint32_t, 4>;
+
+   public:
+    using result_type = uint32_t;  // NOLINT(readability-identifier-naming)
+
+    explicit constexpr Philox4x32(
+        uint64_t seed, uint64_t stream = 0)  // NOLINT(fuchsia-default-arguments-declarations)
+        : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)}
+        , stream_{stream} {
+    }
+
+    constexpr uint32_t operator()() {
+        const auto lane = static_cast<size_t>(position_ % 4);
+        if (lane == 0) {
+            buffer_ = Generate(position_ / 4);
+        }
+        ++position_;
+        return buffer_[lane];
+    }
+
+    [[nodiscard]] constexpr uint32_t At(uint64_t index) const {
+        return Generate(index / 4)[index % 4];
+    }
+
+    // The next operator() call returns At(index).
+    constexpr void Seek(uint64_t index) {
+        position_ = index;
+        if (position_ % 4 != 0) {
+            buffer_ = Generate(position_ / 4);
+        }
+    }
+
+    [[nodiscard]] constexpr uint64_t Position() const {
+        return position_;
+    }
+
+    // Same words as out.size() calls of operator(); whole blocks are written in place.
+    constexpr void Fill(std::span<uint32_t> out) {
+        while (position_ % 4 != 0 && !out.empty()) {
+            out.front() = this->operator()();
+            out = out.subspan(1);
+        }
+        for (; out.size() >= 4; out = out.subspan(4)) {
+            const Block block = Generate(position_ / 4);
+            std::copy(block.begin(), block.end(), out.begin());
+            position_ += 4;
+        }
+        for (uint32_t& word : out) {
+            word = this->operator()();
+        }
+    }
+
+    static constexpr uint32_t min() {  // NOLINT(readability-identifier-naming)
+        return 0;
+    }
+
+    static constexpr uint32_t max() {  // NOLINT(readability-identifier-naming)
+        return std::numeric_limits<uint32_t>::max();
+    }
+
+   private:
+    [[nodiscard]] constexpr Block Generate(uint64_t block) const {
+        constexpr uint64_t kMultiplier0 = 0xd2511f53;
+        constexpr uint64_t kMultiplier1 = 0xcd9e8d57;
+        constexpr uint32_t kWeyl0 = 0x9e3779b9;
+        constexpr uint32_t kWeyl1 = 0xbb67ae85;
+        Block counter = {
+            static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+            static_cast<uint32_t>(stream_), static_cast<uint32_t>(stream_ >> 32)};
+        std::array<uint32_t, 2> key = key_;
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t product0 = kMultiplier0 * counter[0];
+            const uint64_t product1 = kMultiplier1 * counter[2];
+            counter = {
+                static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+                static_cast<uint32_t>(product1),
+                static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+                static_cast<uint32_t>(product0)};
+            key[0] += kWeyl0;
+            key[1] += kWeyl1;
+        }
+        return counter;
+    }
+
+    std::array<uint32_t, 2> key_;
+    uint64_t stream_;
+    uint64_t position_ = 0;
+    Block buffer_{};
+};
@@ -0,0 +1,59 @@
+#include "engines.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+TEST_CASE("Philox4x32 matches the Random123 known-answer vectors") {
+    // kat_vectors, philox4x32_10 with a zero counter and key.
+    const Philox4x32 zero{0};
+    constexpr std::array<uint32_t, 4> kZero = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8};
+    for (uint64_t i = 0; i < kZero.size(); ++i) {
+        CHECK(zero.At(i) == kZero[i]);
+    }
+
+    // The published vectors with non-zero counters need blocks past 2^62, which no uint64_t
+    // position reaches; these come from the reference algorithm with the same key and stream
+    // as the pi vector (key a4093822 299f31d0, counter words 2-3 13198a2e 03707344).
+    const Philox4x32 pi{0x299f31d0a4093822, 0x0370734413198a2e};
+    constexpr uint64_t kBlock = 0x1234567;
+    constexpr std::array<uint32_t, 8> kPi = {
+        0x7a725be7, 0x3a1ff8b7, 0xefc26d21, 0x8c03fc2b,
+        0x7d1e8593, 0x754c51d7, 0x0a3cc6d7, 0xfafb521b};
+    for (uint64_t i = 0; i < kPi.size(); ++i) {
+        CHECK(pi.At(kBlock * 4 + i) == kPi[i]);
+    }
+}
+
+TEST_CASE("Philox4x32 Seek, Fill and operator() agree with At") {
+    const Philox4x32 reference{42, 7};
+    for (const uint64_t start : {0, 1, 3, 4, 1001}) {
+        CAPTURE(start);
+        Philox4x32 sequential = reference;
+        sequential.Seek(start);
+        for (uint64_t i = start; i < start + 13; ++i) {
+            CHECK(sequential() == reference.At(i));
+        }
+
+        Philox4x32 filled = reference;
+        filled.Seek(start);
+        std::vector<uint32_t> words(13);
+        filled.Fill(words);
+        for (uint64_t i = 0; i < words.size(); ++i) {
+            CHECK(words[i] == reference.At(start + i));
+        }
+        CHECK(filled.Position() == start + words.size());
+    }
+}
+
+TEST_CASE("Philox4x32 streams differ") {
+    const Philox4x32 first{1, 0};
+    const Philox4x32 second{1, 1};
+    int equal = 0;
+    for (uint64_t i = 0; i < 64; ++i) {
+        equal += static_cast<int>(first.At(i) == second.At(i));
+    }
+    CHECK(equal < 2);
+}
@@ -0,0 +1,483 @@
+#pragma once
+
+#include "util.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Benchmark fixtures: typed columns generated in parallel into one memory mapping, which can
+// be saved to a file and mapped back, so later runs skip generation. The file is a plain
+// dump of the mapping in the native byte order, meant as a local cache, not an exchange
+// format.
+//
+//     const Fixture fixture = FixtureBuilder{42}
+//                                 .Integral<int64_t>("keys", 100'000'000, 0, 1'000'000)
+//                                 .Real("prices", 100'000'000, 0., 100.)
+//                                 .LoadOrBuild("/tmp/orders.fixture");
+//     std::span<const int64_t> keys = fixture.Column<int64_t>("keys");
+
+// One anonymous or file mapping, unmapped on destruction.
+class MappedArena {
+   public:
+    // Zero-filled. With huge_pages, asks for explicit huge pages first and falls back to
+    // transparent huge pages when none are reserved. Platforms without either (macOS) ignore
+    // huge_pages.
+    static MappedArena Allocate(size_t size, bool huge_pages) {
+        size = std::max<size_t>(size, 1);
+        constexpr int kFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+        constexpr size_t kHugePage = size_t{1} << 21;
+        if (huge_pages) {
+            const size_t huge_size = (size + kHugePage - 1) / kHugePage * kHugePage;
+            void* data = ::mmap(
+                nullptr, huge_size, PROT_READ | PROT_WRITE, kFlags | MAP_HUGETLB, -1, 0);
+            if (data != MAP_FAILED) {
+                return {data, huge_size};
+            }
+        }
+#endif
+        void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, kFlags, -1, 0);
+        if (data == MAP_FAILED) {
+            throw std::system_error{errno, std::generic_category()};
+        }
+#ifdef MADV_HUGEPAGE
+        if (huge_pages) {
+            // Only a hint; the kernel may have THP disabled.
+            ::madvise(data, size, MADV_HUGEPAGE);
+        }
+#else
+        (void)huge_pages;
+#endif
+        return {data, size};
+    }
+
+    // Read-only view of the whole file; pages are loaded on first access.
+    static MappedArena MapFile(const std::filesystem::path& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error{errno, std::generic_category()};
+        }
+        struct stat info {};
+        if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+            const int error = info.st_size == 0 ? EINVAL : errno;
+            ::close(fd);
+            throw std::system_error{error, std::generic_category()};
+        }
+        const auto size = static_cast<size_t>(info.st_size);
+        void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const int error = errno;
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            throw std::system_error{error, std::generic_category()};
+        }
+        return {data, size};
+    }
+
+    MappedArena(const MappedArena&) = delete;
+    MappedArena& operator=(const MappedArena&) = delete;
+
+    MappedArena(MappedArena&& other) noexcept
+        : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)} {
+    }
+
+    MappedArena& operator=(MappedArena&& other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+
+    ~MappedArena() {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    // Writable only for Allocate'd arenas.
+    [[nodiscard]] std::span<std::byte> Bytes() const {
+        return {static_cast<std::byte*>(data_), size_};
+    }
+
+   private:
+    MappedArena(void* data, size_t size) : data_{data}, size_{size} {
+    }
+
+    void* data_;
+    size_t size_;
+};
+
+enum class ColumnType : uint32_t {
+    kInt32 = 1,
+    kInt64,
+    kUint32,
+    kUint64,
+    kDouble,
+};
+
+template <class T>
+constexpr ColumnType ColumnTypeOf() {
+    if constexpr (std::is_same_v<T, int32_t>) {
+        return ColumnType::kInt32;
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+        return ColumnType::kInt64;
+    } else if constexpr (std::is_same_v<T, uint32_t>) {
+        return ColumnType::kUint32;
+    } else if constexpr (std::is_same_v<T, uint64_t>) {
+        return ColumnType::kUint64;
+    } else {
+        static_assert(std::is_same_v<T, double>, "unsupported column type");
+        return ColumnType::kDouble;
+    }
+}
+
+// On-disk layout: a FixtureHeader and its ColumnRecords, padded to kFixturePage, then the
+// columns, each aligned to kFixtureAlignment. A built fixture has the same layout in memory,
+// so saving is a single write.
+namespace fixture_detail {
+inline constexpr size_t kFixturePage = 4096;
+inline constexpr size_t kFixtureAlignment = 64;
+inline constexpr std::array<char, 8> kMagic = {'O', 'F', 'F', 'I', 'X', 'T', '0', '1'};
+
+enum class ColumnKind : uint32_t {
+    kIntegral = 1,
+    kReal,
+    kPermutation,
+};
+
+struct FixtureHeader {
+    std::array<char, 8> magic;
+    uint64_t seed;
+    uint64_t columns;
+    uint64_t size;
+};
+
+// Everything that determines a column's contents, plus where it is.
+struct ColumnRecord {
+    std::array<char, 48> name;
+    ColumnType type;
+    ColumnKind kind;
+    uint64_t count;
+    // Range bounds as the bits of the column's own type.
+    uint64_t from;
+    uint64_t to;
+    uint64_t offset;
+
+    [[nodiscard]] std::string_view Name() const {
+        return {name.data(), ::strnlen(name.data(), name.size())};
+    }
+
+    [[nodiscard]] size_t Bytes() const {
+        return count * (type == ColumnType::kInt32 || type == ColumnType::kUint32 ? 4 : 8);
+    }
+
+    bool operator==(const ColumnRecord&) const = default;
+};
+
+static_assert(std::is_trivially_copyable_v<FixtureHeader>);
+static_assert(std::is_trivially_copyable_v<ColumnRecord>);
+
+template <class T>
+uint64_t ToBits(T value) {
+    if constexpr (sizeof(T) == 4) {
+        return std::bit_cast<uint32_t>(value);
+    } else {
+        return std::bit_cast<uint64_t>(value);
+    }
+}
+
+template <class T>
+T FromBits(uint64_t bits) {
+    if constexpr (sizeof(T) == 4) {
+        return std::bit_cast<T>(static_cast<uint32_t>(bits));
+    } else {
+        return std::bit_cast<T>(bits);
+    }
+}
+
+inline size_t AlignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+}  // namespace fixture_detail
+
+class Fixture {
+   public:
+    // Maps a file written by Save. Throws std::runtime_error if it is not a valid fixture.
+    static Fixture Load(const std::filesystem::path& path) {
+        Fixture fixture(MappedArena::MapFile(path));
+        if (!fixture.Valid()) {
+            throw std::runtime_error{"Not a fixture file: " + path.string()};
+        }
+        return fixture;
+    }
+
+    // Writes to a temporary file next to path and renames it, so readers never map a
+    // partial fixture.
+    void Save(const std::filesystem::path& path) const {
+        std::filesystem::path temporary = path;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            const auto bytes = Bytes();
+            file.write(reinterpret_cast<const char*>(bytes.data()),  // NOLINT(*-reinterpret-cast)
+                       static_cast<std::streamsize>(bytes.size()));
+            if (!file.flush()) {
+                throw std::runtime_error{"Failed to write " + temporary.string()};
+            }
+        }
+        std::filesystem::rename(temporary, path);
+    }
+
+    template <class T>
+    [[nodiscard]] std::span<const T> Column(std::string_view name) const {
+        const fixture_detail::ColumnRecord& record = Find(name);
+        if (record.type != ColumnTypeOf<T>()) {
+            throw std::invalid_argument{"Wrong type for fixture column " + std::string{name}};
+        }
+        return {reinterpret_cast<const T*>(  // NOLINT(*-reinterpret-cast)
+                    arena_.Bytes().subspan(record.offset).data()),
+                record.count};
+    }
+
+    [[nodiscard]] uint64_t Seed() const {
+        return Header().seed;
+    }
+
+    [[nodiscard]] std::span<const fixture_detail::ColumnRecord> Records() const {
+        return {reinterpret_cast<const fixture_detail::ColumnRecord*>(  // NOLINT
+                    arena_.Bytes().subspan(sizeof(fixture_detail::FixtureHeader)).data()),
+                Header().columns};
+    }
+
+   private:
+    friend class FixtureBuilder;
+
+    explicit Fixture(MappedArena arena) : arena_{std::move(arena)} {
+    }
+
+    [[nodiscard]] const fixture_detail::FixtureHeader& Header() const {
+        return *reinterpret_cast<const fixture_detail::FixtureHeader*>(  // NOLINT
+            arena_.Bytes().data());
+    }
+
+    // The used part of the arena; huge page mappings are rounded up past it.
+    [[nodiscard]] std::span<const std::byte> Bytes() const {
+        return arena_.Bytes().first(Header().size);
+    }
+
+    [[nodiscard]] bool Valid() const {
+        using fixture_detail::ColumnRecord;
+        using fixture_detail::FixtureHeader;
+        const size_t size = arena_.Bytes().size();
+        if (size < sizeof(FixtureHeader) || Header().magic != fixture_detail::kMagic ||
+            Header().size != size ||
+            Header().columns > (size - sizeof(FixtureHeader)) / sizeof(ColumnRecord)) {
+            return false;
+        }
+        return std::ranges::all_of(Records(), [size](const ColumnRecord& record) {
+            const bool known_type =
+                record.type >= ColumnType::kInt32 && record.type <= ColumnType::kDouble;
+            // The count check keeps Bytes() from overflowing.
+            return known_type && record.offset % fixture_detail::kFixtureAlignment == 0 &&
+                   record.offset <= size && record.count <= size / 4 &&
+                   record.Bytes() <= size - record.offset;
+        });
+    }
+
+    [[nodiscard]] const fixture_detail::ColumnRecord& Find(std::string_view name) const {
+        for (const fixture_detail::ColumnRecord& record : Records()) {
+            if (record.Name() == name) {
+                return record;
+            }
+        }
+        throw std::out_of_range{"No fixture column " + std::string{name}};
+    }
+
+    MappedArena arena_;
+};
+
+struct FixtureOptions {
+    ParallelOptions parallel;
+    bool huge_pages = false;
+};
+
+// Describes the columns; the fixture is a pure function of the seed and the columns in the
+// order they were added, whatever the thread count.
+class FixtureBuilder {
+   public:
+    explicit FixtureBuilder(uint64_t seed) : seed_{seed} {
+    }
+
+    // Uniform on [from, to].
+    template <class T>
+    FixtureBuilder& Integral(std::string_view name, size_t count, T from, T to) {
+        Add(name, ColumnTypeOf<T>(), fixture_detail::ColumnKind::kIntegral, count,
+            fixture_detail::ToBits(from), fixture_detail::ToBits(to));
+        return *this;
+    }
+
+    // Uniform on [from, to).
+    FixtureBuilder& Real(std::string_view name, size_t count, double from, double to) {
+        Add(name, ColumnType::kDouble, fixture_detail::ColumnKind::kReal, count,
+            fixture_detail::ToBits(from), fixture_detail::ToBits(to));
+        return *this;
+    }
+
+    // A random permutation of [0, count).
+    template <class T>
+    FixtureBuilder& Permutation(std::string_view name, size_t count) {
+        static_assert(std::is_integral_v<T>, "permutation columns must be integral");
+        Add(name, ColumnTypeOf<T>(), fixture_detail::ColumnKind::kPermutation, count, 0, 0);
+        return *this;
+    }
+
+    [[nodiscard]] Fixture Build(const FixtureOptions& options = {}) const {  // NOLINT
+        using fixture_detail::ColumnRecord;
+        using fixture_detail::FixtureHeader;
+        const size_t size = Size();
+        MappedArena arena = MappedArena::Allocate(size, options.huge_pages);
+        const std::span<std::byte> bytes = arena.Bytes();
+        const FixtureHeader header{fixture_detail::kMagic, seed_, records_.size(), size};
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        std::memcpy(bytes.subspan(sizeof(header)).data(), records_.data(),
+                    records_.size() * sizeof(ColumnRecord));
+
+        FastRandomGenerator gen{seed_};
+        for (const ColumnRecord& record : records_) {
+            const auto column = bytes.subspan(record.offset, record.Bytes());
+            switch (record.type) {
+                case ColumnType::kInt32:
+                    FillColumn<int32_t>(gen, record, column, options.parallel);
+                    break;
+                case ColumnType::kInt64:
+                    FillColumn<int64_t>(gen, record, column, options.parallel);
+                    break;
+                case ColumnType::kUint32:
+                    FillColumn<uint32_t>(gen, record, column, options.parallel);
+                    break;
+                case ColumnType::kUint64:
+                    FillColumn<uint64_t>(gen, record, column, options.parallel);
+                    break;
+                case ColumnType::kDouble:
+                    FillColumn<double>(gen, record, column, options.parallel);
+                    break;
+            }
+        }
+        return Fixture(std::move(arena));
+    }
+
+    // Maps path if it holds exactly this fixture; otherwise builds it and saves it there.
+    [[nodiscard]] Fixture LoadOrBuild(
+        const std::filesystem::path& path,
+        const FixtureOptions& options = {}) const {  // NOLINT
+        if (std::filesystem::exists(path)) {
+            try {
+                Fixture fixture = Fixture::Load(path);
+                if (fixture.Seed() == seed_ &&
+                    std::ranges::equal(fixture.Records(), records_)) {
+                    return fixture;
+                }
+            } catch (const std::runtime_error&) {
+                // Stale or truncated; rebuilt below.
+            }
+        }
+        Fixture fixture = Build(options);
+        fixture.Save(path);
+        return fixture;
+    }
+
+   private:
+    void Add(std::string_view name, ColumnType type, fixture_detail::ColumnKind kind,
+             size_t count, uint64_t from, uint64_t to) {
+        fixture_detail::ColumnRecord record{};
+        if (name.empty() || name.size() >= record.name.size()) {
+            throw std::invalid_argument{"Fixture column names must have 1 to 47 characters"};
+        }
+        if (std::ranges::any_of(records_, [name](const auto& other) {
+                return other.Name() == name;
+            })) {
+            throw std::invalid_argument{"Duplicate fixture column " + std::string{name}};
+        }
+        std::ranges::copy(name, record.name.begin());
+        record.type = type;
+        record.kind = kind;
+        record.count = count;
+        record.from = from;
+        record.to = to;
+        records_.push_back(record);
+        // The header grows with every column, which moves all of them.
+        PlaceColumns();
+    }
+
+    void PlaceColumns() {
+        const size_t data = fixture_detail::AlignUp(
+            sizeof(fixture_detail::FixtureHeader) +
+                records_.size() * sizeof(fixture_detail::ColumnRecord),
+            fixture_detail::kFixturePage);
+        size_t offset = data;
+        for (fixture_detail::ColumnRecord& record : records_) {
+            record.offset = offset;
+            offset = fixture_detail::AlignUp(offset + record.Bytes(), kAlignment);
+        }
+    }
+
+    [[nodiscard]] size_t Size() const {
+        if (records_.empty()) {
+            return fixture_detail::AlignUp(
+                sizeof(fixture_detail::FixtureHeader), fixture_detail::kFixturePage);
+        }
+        return records_.back().offset + records_.back().Bytes();
+    }
+
+    template <class T>
+    static void FillColumn(
+        FastRandomGenerator& gen, const fixture_detail::ColumnRecord& record,
+        std::span<std::byte> bytes, const ParallelOptions& options) {
+        const std::span<T> column{
+            reinterpret_cast<T*>(bytes.data()), record.count};  // NOLINT(*-reinterpret-cast)
+        switch (record.kind) {
+            case fixture_detail::ColumnKind::kIntegral:
+                if constexpr (std::is_integral_v<T>) {
+                    gen.FillIntegral(
+                        column, fixture_detail::FromBits<T>(record.from),
+                        fixture_detail::FromBits<T>(record.to), options);
+                }
+                break;
+            case fixture_detail::ColumnKind::kReal:
+                if constexpr (std::is_same_v<T, double>) {
+                    gen.FillReal(
+                        column, fixture_detail::FromBits<T>(record.from),
+                        fixture_detail::FromBits<T>(record.to), options);
+                }
+                break;
+            case fixture_detail::ColumnKind::kPermutation:
+                if constexpr (std::is_integral_v<T>) {
+                    gen.FillPermutation(column, options);
+                }
+                break;
+        }
+    }
+
+    static constexpr size_t kAlignment = fixture_detail::kFixtureAlignment;
+
+    uint64_t seed_;
+    std::vector<fixture_detail::ColumnRecord> records_;
+};
@@ -1,12 +1,21 @@
 #pragma once
 
 #include "dist.h"
+#include "engines.h"
 
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cstdint>
 #include <filesystem>
 #include <numeric>
 #include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #ifdef __linux__
@@ -14,10 +23,72 @@
 #include <sys/time.h>
 #endif
 
-class RandomGenerator {
+// How the parallel Gen*/Fill* overloads split the output between threads.
+enum class StreamMode {
+    // Output chunk c is drawn from an engine seeded with the c-th word of SplitMix64(root),
+    // so the result depends only on the seed, not on the thread count.
+    kCounter,
+    // Thread t draws its contiguous part of the output from the root engine jumped t times.
+    // The fastest mode, but the result changes with the thread count. Needs an engine with
+    // Jump(), such as Xoshiro256StarStar.
+    kJump,
+};
+
+struct ParallelOptions {
+    // std::thread::hardware_concurrency() when not positive.
+    int threads = 0;
+    StreamMode mode = StreamMode::kCounter;
+};
+
+// The index-th word of SplitMix64(root): seeds for independent substreams of one root seed.
+constexpr uint64_t SubstreamSeed(uint64_t root, uint64_t index) {
+    return SplitMix64{root + index * 0x9e3779b97f4a7c15}();
+}
+
+// Many strings in one allocation, seen as string_views. Move-only: the views point into the
+// buffer, which a move keeps in place and a copy would not.
+class StringBatch {
+   public:
+    StringBatch(std::vector<char> chars, std::span<const size_t> lengths)
+        : chars_{std::move(chars)} {
+        views_.reserve(lengths.size());
+        size_t begin = 0;
+        for (const size_t length : lengths) {
+            views_.emplace_back(chars_.data() + begin, length);  // NOLINT(*-pointer-arithmetic)
+            begin += length;
+        }
+    }
+
+    StringBatch(const StringBatch&) = delete;
+    StringBatch& operator=(const StringBatch&) = delete;
+    StringBatch(StringBatch&&) noexcept = default;
+    StringBatch& operator=(StringBatch&&) noexcept = default;
+    ~StringBatch() = default;
+
+    [[nodiscard]] std::span<const std::string_view> Strings() const {
+        return views_;
+    }
+
+    [[nodiscard]] size_t Size() const {
+        return views_.size();
+    }
+
+    std::string_view operator[](size_t i) const {
+        return views_[i];
+    }
+
+   private:
+    std::vector<char> chars_;
+    std::vector<std::string_view> views_;
+};
+
+// Engine is any std::uniform_random_bit_generator constructible from an integer seed, such
+// as the ones in engines.h.
+template <class Engine>
+class BasicRandomGenerator {
    public:
-    explicit RandomGenerator(
-        uint32_t seed = 738'547'485U)  // NOLINT(fuchsia-default-arguments-declarations)
+    explicit BasicRandomGenerator(
+        uint64_t seed = 738'547'485U)  // NOLINT(fuchsia-default-arguments-declarations)
         : gen_(seed) {
     }
 
@@ -25,34 +96,118 @@ class RandomGenerator {
     std::vector<T> GenIntegralVector(size_t count, T from, T to) {
         UniformIntDistribution dist{from, to};
         std::vector<T> result(count);
-        for (auto& cur : result) {
-            cur = dist(gen_);
-        }
+        dist.Fill(gen_, std::span<T>(result));
+        return result;
+    }
+
+    // Parallel versions. Each call draws one root seed from this generator, so successive
+    // calls produce different data and the whole sequence stays reproducible from the seed.
+    template <class T>
+    void FillIntegral(std::span<T> out, T from, T to, const ParallelOptions& options) {
+        const auto fill = [dist = UniformIntDistribution{from, to}](
+                              Engine& engine, std::span<T> part) mutable {
+            dist.Fill(engine, part);
+        };
+        ParallelFill(out, options, fill);
+    }
+
+    template <class T>
+    std::vector<T> GenIntegralVector(
+        size_t count, T from, T to, const ParallelOptions& options) {
+        std::vector<T> result(count);
+        FillIntegral(std::span<T>(result), from, to, options);
+        return result;
+    }
+
+    void FillReal(std::span<double> out, double from, double to, const ParallelOptions& options) {
+        const auto fill = [dist = UniformRealDistribution{from, to}](
+                              Engine& engine, std::span<double> part) mutable {
+            dist.Fill(engine, part);
+        };
+        ParallelFill(out, options, fill);
+    }
+
+    std::vector<double> GenRealVector(
+        size_t count, double from, double to, const ParallelOptions& options) {
+        std::vector<double> result(count);
+        FillReal(std::span<double>(result), from, to, options);
         return result;
     }
 
     std::string GenString(
         size_t count, char from = 'a',  // NOLINT(fuchsia-default-arguments-declarations)
         char to = 'z') {                // NOLINT(fuchsia-default-arguments-declarations)
-        UniformIntDistribution<int> dist{from, to};
-        std::string result(count, from);
-        for (char& x : result) {
-            x = static_cast<char>(dist(gen_));
+        std::string alphabet;
+        for (int c = from; c <= to; ++c) {
+            alphabet.push_back(static_cast<char>(c));
         }
+        return GenString(count, alphabet);
+    }
+
+    std::string GenString(size_t count, std::string_view alphabet) {
+        std::string result(count, '\0');
+        FillString(std::span<char>(result), alphabet);
         return result;
     }
 
+    // Uniform characters of the alphabet, which may repeat characters to weight them and
+    // holds at most 256. Random words are cut into bytes and mapped through a 256-entry
+    // table; when the size does not divide 256, the bytes past its largest multiple are
+    // dropped.
+    void FillString(std::span<char> out, std::string_view alphabet) {
+        if (alphabet.empty() || alphabet.size() > 256) {
+            throw std::invalid_argument{"alphabet must have 1 to 256 characters"};
+        }
+        const size_t limit = 256 - 256 % alphabet.size();
+        std::array<char, 256> table;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        for (size_t byte = 0; byte < table.size(); ++byte) {
+            table[byte] = alphabet[byte % alphabet.size()];
+        }
+        constexpr size_t kBlock = 512;
+        std::array<uint64_t, kBlock> words;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+        std::array<char, kBlock * 8> chars;   // NOLINT(cppcoreguidelines-pro-type-member-init)
+        while (!out.empty()) {
+            // Enough words for the rest of out on average.
+            const size_t count = std::min(kBlock, (out.size() * 256 / limit + 7) / 8);
+            dist_detail::FillRandomWords(gen_, std::span<uint64_t>(words.data(), count));
+            // Compacted branch-free, so every byte gets a slot in chars.
+            size_t kept = 0;
+            for (size_t i = 0; i < count; ++i) {
+                for (int shift = 0; shift < 64; shift += 8) {
+                    const auto byte = static_cast<uint8_t>(words[i] >> shift);
+                    chars[kept] = table[byte];
+                    kept += byte < limit ? 1 : 0;
+                }
+            }
+            const size_t size = std::min(out.size(), kept);
+            std::copy_n(chars.begin(), size, out.begin());
+            out = out.subspan(size);
+        }
+    }
+
+    // length(engine) gives the length of each string, e.g. UniformIntDistribution<size_t> or
+    // ZipfDistribution<size_t>. All characters are drawn in one FillString call.
+    template <class LengthDist>
+    StringBatch GenStrings(size_t count, const LengthDist& length, std::string_view alphabet) {
+        std::vector<size_t> lengths(count);
+        for (size_t& x : lengths) {
+            x = static_cast<size_t>(length(gen_));
+        }
+        std::vector<char> chars(std::reduce(lengths.begin(), lengths.end(), size_t{0}));
+        FillString(std::span<char>(chars), alphabet);
+        return StringBatch(std::move(chars), lengths);
+    }
+
     std::vector<double> GenRealVector(size_t count, double from, double to) {
         UniformRealDistribution dist{from, to};
         std::vector<double> result(count);
-        for (auto& cur : result) {
-            cur = dist(gen_);
-        }
+        dist.Fill(gen_, std::span<double>(result));
         return result;
     }
 
-    std::vector<int> GenPermutation(size_t count) {
-        std::vector<int> result(count);
+    template <class T = int>
+    std::vector<T> GenPermutation(size_t count) {
+        std::vector<T> result(count);
         std::iota(result.begin(), result.end(), 0);
         std::ranges::shuffle(result, gen_);
         return result;
@@ -88,8 +243,230 @@ class RandomGenerator {
         std::shuffle(first, last, gen_);
     }
 
+    // Parallel, cache-friendly versions (bucket scatter, after Sanders): every element is sent
+    // to a uniformly random bucket sized to fit in cache, then each bucket is shuffled on its
+    // own. Both steps run in parallel and touch memory almost sequentially. The result depends
+    // only on the generator state and the size, not on the thread count.
+    template <class T = int>
+    std::vector<T> GenPermutation(size_t count, const ParallelOptions& options) {
+        std::vector<T> result(count);
+        FillPermutation(std::span<T>(result), options);
+        return result;
+    }
+
+    template <class T>
+    void FillPermutation(std::span<T> out, const ParallelOptions& options) {
+        ScatterShuffle(out, [](size_t i) { return static_cast<T>(i); }, options);
+    }
+
+    // Needs a copy of the data as scratch space.
+    template <class T>
+    void Shuffle(std::span<T> data, const ParallelOptions& options) {
+        const std::vector<T> source(data.begin(), data.end());
+        ScatterShuffle(data, [&source](size_t i) { return source[i]; }, options);
+    }
+
    private:
-    std::mt19937 gen_;
+    // Elements per independently seeded chunk in StreamMode::kCounter.
+    static constexpr size_t kCounterChunk = size_t{1} << 16;
+
+    // Bucket scatter shuffle: the input is cut into a fixed number of parts and the output into
+    // buckets of about kShuffleBucketBytes.
+    static constexpr size_t kShuffleParts = 64;
+    static constexpr size_t kShuffleBucketBytes = size_t{1} << 18;
+    static constexpr size_t kMaxShuffleBuckets = size_t{1} << 12;
+
+    static size_t ThreadCount(const ParallelOptions& options) {
+        return options.threads > 0 ? options.threads
+                                   : std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    static Engine SubstreamEngine(uint64_t root, uint64_t index) {
+        return Engine(SubstreamSeed(root, index));
+    }
+
+    // Calls run(task) for every task in [0, tasks); thread t takes tasks t, t + threads, ...
+    template <class Run>
+    static void RunTasks(size_t tasks, const ParallelOptions& options, const Run& run) {
+        const size_t threads = std::min(ThreadCount(options), tasks);
+        std::vector<std::thread> workers;
+        for (size_t thread = 0; thread < threads; ++thread) {
+            workers.emplace_back([&run, thread, threads, tasks] {
+                for (size_t task = thread; task < tasks; task += threads) {
+                    run(task);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    template <class T, class Source>
+    void ScatterShuffle(std::span<T> out, const Source& source, const ParallelOptions& options) {
+        const uint64_t root = UniformIntDistribution<uint64_t>{0}(gen_);
+        const size_t count = out.size();
+        const size_t parts = std::clamp<size_t>(count / kCounterChunk, 1, kShuffleParts);
+        const size_t buckets = std::bit_ceil(
+            std::clamp<size_t>(count * sizeof(T) / kShuffleBucketBytes, 1, kMaxShuffleBuckets));
+        const auto part_begin = [count, parts](size_t part) {
+            return count / parts * part + std::min(part, count % parts);
+        };
+        // Visits every element of the part with its bucket. The engine is reseeded on every
+        // call, so the counting and the scattering pass see the same buckets.
+        const auto for_each_bucket = [&](size_t part, const auto& visit) {
+            constexpr size_t kBlock = 256;
+            Engine engine = SubstreamEngine(root, part);
+            const UniformIntDistribution<uint32_t> bucket_of{
+                0, static_cast<uint32_t>(buckets - 1)};
+            std::array<uint32_t, kBlock> ids;  // NOLINT(cppcoreguidelines-pro-type-member-init)
+            for (size_t i = part_begin(part), end = part_begin(part + 1); i < end;) {
+                const size_t size = std::min(kBlock, end - i);
+                bucket_of.Fill(engine, std::span<uint32_t>(ids.data(), size));
+                for (size_t k = 0; k < size; ++k) {
+                    visit(i + k, ids[k]);
+                }
+                i += size;
+            }
+        };
+
+        // Counts per part and bucket, then turned into write positions: bucket-major, so
+        // every bucket is contiguous, and part-minor within a bucket.
+        std::vector<size_t> positions(parts * buckets);
+        RunTasks(parts, options, [&](size_t part) {
+            for_each_bucket(part, [&](size_t, uint32_t bucket) {
+                ++positions[part * buckets + bucket];
+            });
+        });
+        std::vector<size_t> bucket_begin(buckets + 1);
+        size_t position = 0;
+        for (size_t bucket = 0; bucket < buckets; ++bucket) {
+            bucket_begin[bucket] = position;
+            for (size_t part = 0; part < parts; ++part) {
+                position += std::exchange(positions[part * buckets + bucket], position);
+            }
+        }
+        bucket_begin[buckets] = position;
+        RunTasks(parts, options, [&](size_t part) {
+            for_each_bucket(part, [&](size_t i, uint32_t bucket) {
+                out[positions[part * buckets + bucket]++] = source(i);
+            });
+        });
+        RunTasks(buckets, options, [&](size_t bucket) {
+            Engine engine = SubstreamEngine(root, parts + bucket);
+            const size_t begin = bucket_begin[bucket];
+            FisherYates(engine, out.subspan(begin, bucket_begin[bucket + 1] - begin));
+        });
+    }
+
+    // Unlike std::shuffle, the same on every standard library.
+    template <class T>
+    static void FisherYates(Engine& engine, std::span<T> items) {
+        for (size_t i = items.size(); i > 1; --i) {
+            const size_t j = UniformIntDistribution<size_t>{0, i - 1}(engine);
+            std::swap(items[i - 1], items[j]);
+        }
+    }
+
+    template <class T, class FillPart>
+    void ParallelFill(std::span<T> out, const ParallelOptions& options, FillPart fill_part) {
+        const uint64_t root = UniformIntDistribution<uint64_t>{0}(gen_);
+        if (options.mode == StreamMode::kJump) {
+            const size_t threads = ThreadCount(options);
+            std::vector<std::thread> workers;
+            if constexpr (requires(Engine& engine) { engine.Jump(); }) {
+                const size_t part = (out.size() + threads - 1) / std::max<size_t>(threads, 1);
+                Engine engine(root);
+                for (size_t begin = 0; begin < out.size(); begin += part) {
+                    const auto items = out.subspan(begin, std::min(part, out.size() - begin));
+                    workers.emplace_back([engine, fill_part, items]() mutable {
+                        fill_part(engine, items);
+                    });
+                    engine.Jump();
+                }
+                for (std::thread& worker : workers) {
+                    worker.join();
+                }
+            } else {
+                throw std::invalid_argument{"StreamMode::kJump needs an engine with Jump()"};
+            }
+        } else {
+            const size_t chunks = (out.size() + kCounterChunk - 1) / kCounterChunk;
+            RunTasks(chunks, options, [&](size_t chunk) {
+                Engine engine = SubstreamEngine(root, chunk);
+                const size_t begin = chunk * kCounterChunk;
+                auto fill = fill_part;
+                fill(engine, out.subspan(begin, std::min(kCounterChunk, out.size() - begin)));
+            });
+        }
+    }
+
+    Engine gen_;
+};
+
+// std::mt19937 keeps the sequences of existing seeds.
+using RandomGenerator = BasicRandomGenerator<std::mt19937>;
+using FastRandomGenerator = BasicRandomGenerator<Xoshiro256StarStar>;
+
+// One generator per worker thread, seeded with SubstreamSeed(root, worker), so runs are
+// reproducible as long as each worker keeps its index. Generator is any engine or
+// BasicRandomGenerator constructible from a uint64_t seed. Slots sit on separate cache
+// lines and are never shared, so no locking is needed; each slot must only be used by one
+// thread at a time.
+//
+//     GeneratorPool<Xoshiro256StarStar> pool{seed, threads};
+//     // in worker i:
+//     pool.Bind(i);
+//     const double x = NormalDistribution{}(GeneratorPool<Xoshiro256StarStar>::Local());
+template <class Generator>
+class GeneratorPool {
+   public:
+    GeneratorPool(uint64_t root, size_t workers) {
+        slots_.reserve(workers);
+        for (size_t worker = 0; worker < workers; ++worker) {
+            slots_.emplace_back(SubstreamSeed(root, worker));
+        }
+    }
+
+    GeneratorPool(const GeneratorPool&) = delete;
+    GeneratorPool& operator=(const GeneratorPool&) = delete;
+    GeneratorPool(GeneratorPool&&) noexcept = default;
+    GeneratorPool& operator=(GeneratorPool&&) noexcept = default;
+    ~GeneratorPool() = default;
+
+    Generator& operator[](size_t worker) {
+        return slots_[worker].generator;
+    }
+
+    [[nodiscard]] size_t Size() const {
+        return slots_.size();
+    }
+
+    // Makes Local() return the worker's generator on the calling thread. A thread bound to
+    // several pools of the same Generator type sees the last one.
+    void Bind(size_t worker) {
+        local_ = &slots_.at(worker).generator;
+    }
+
+    // Throws std::logic_error on a thread that was never bound.
+    static Generator& Local() {
+        if (local_ == nullptr) {
+            throw std::logic_error{"GeneratorPool::Local() on an unbound thread"};
+        }
+        return *local_;
+    }
+
+   private:
+    struct alignas(64) Slot {
+        explicit Slot(uint64_t seed) : generator(seed) {
+        }
+
+        Generator generator;
+    };
+
+    static inline thread_local Generator* local_ = nullptr;
+
+    std::vector<Slot> slots_;
 };
 
 inline std::filesystem::path GetFileDir(std::string file, bool without_check = false) {  // NOLINT
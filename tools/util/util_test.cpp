@@ -0,0 +1,64 @@
+#include "util.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace {
+// A few chunks of the counter mode plus a partial one.
+constexpr size_t kCount = (size_t{1} << 16) * 3 + 12'345;
+constexpr uint64_t kSeed = 20'240'917;
+
+template <class Generator>
+void CheckThreadCountIndependence() {
+    Generator reference_gen{kSeed};
+    const ParallelOptions single{.threads = 1};
+    const auto integers = reference_gen.GenIntegralVector(kCount, -1'000, 1'000'000, single);
+    const auto reals = reference_gen.GenRealVector(kCount, -1., 1., single);
+    const auto permutation = reference_gen.GenPermutation(kCount, single);
+
+    for (const int threads : {2, 3, 8}) {
+        CAPTURE(threads);
+        Generator gen{kSeed};
+        const ParallelOptions options{.threads = threads};
+        CHECK(gen.GenIntegralVector(kCount, -1'000, 1'000'000, options) == integers);
+        CHECK(gen.GenRealVector(kCount, -1., 1., options) == reals);
+        CHECK(gen.GenPermutation(kCount, options) == permutation);
+    }
+}
+}  // namespace
+
+TEST_CASE("Counter mode output does not depend on the thread count") {
+    SECTION("RandomGenerator") {
+        CheckThreadCountIndependence<RandomGenerator>();
+    }
+    SECTION("FastRandomGenerator") {
+        CheckThreadCountIndependence<FastRandomGenerator>();
+    }
+    SECTION("Philox4x32") {
+        CheckThreadCountIndependence<BasicRandomGenerator<Philox4x32>>();
+    }
+}
+
+TEST_CASE("Counter mode output depends on the seed and on earlier calls") {
+    FastRandomGenerator gen{kSeed};
+    const ParallelOptions options{.threads = 4};
+    const auto first = gen.GenIntegralVector<int64_t>(kCount, 0, 1'000'000'000, options);
+    const auto second = gen.GenIntegralVector<int64_t>(kCount, 0, 1'000'000'000, options);
+    CHECK(first != second);
+    FastRandomGenerator other{kSeed + 1};
+    CHECK(other.GenIntegralVector<int64_t>(kCount, 0, 1'000'000'000, options) != first);
+}
+
+TEST_CASE("Parallel GenPermutation returns a permutation") {
+    FastRandomGenerator gen{kSeed};
+    auto permutation = gen.GenPermutation(kCount, {.threads = 4});
+    std::vector<int> identity(kCount);
+    std::iota(identity.begin(), identity.end(), 0);
+    CHECK(permutation != identity);
+    std::ranges::sort(permutation);
+    CHECK(permutation == identity);
+}
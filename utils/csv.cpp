@@ -4,54 +4,102 @@
 
 #include "csv.h"
 
+#include "csv_compress.h"
+#include "csv_writer.h"
+#include "tools/util/util.h"
+
 #include <QFile>
 #include <QFileDialog>
-#include <QLatin1Char>
+#include <QIODevice>
 #include <QMessageBox>
 #include <QSqlQuery>
-#include <QSqlRecord>
 #include <QString>
 #include <QStringLiteral>
-#include <QTextStream>
-#include <QtCore/qstringconverter_base.h>
 
-QString outfit::utils::csv::EscapeCSV(QString unexc) {
-    if (!unexc.contains(QLatin1Char(','))) {
-        return unexc;
+namespace {
+QString CsvFileFilter() {
+    QString filter = QStringLiteral("CSV (*.csv);;Gzip CSV (*.csv.gz)");
+    if (outfit::utils::csv::IsCompressionAvailable(outfit::utils::csv::Compression::kZstd)) {
+        filter += QStringLiteral(";;Zstandard CSV (*.csv.zst)");
     }
-    return '\"' + unexc.replace(QLatin1Char('\"'), QStringLiteral("\"\"")) + '\"';
+    return filter;
 }
+}  // namespace
 
 void outfit::utils::csv::SaveQuery(const QString& header, QSqlQuery& query) {
+    SaveQuery(header, query, {});
+}
+
+void outfit::utils::csv::SaveQuery(
+    const QString& header, QSqlQuery& query, const StatsCallback& on_stats) {
     const QString file_name =
-        QFileDialog::getSaveFileName(nullptr, "export.csv", ".", "CSV (*.csv)");
+        QFileDialog::getSaveFileName(nullptr, "export.csv", ".", CsvFileFilter());
     if (file_name == "") {
         return;
     }
+    const Compression compression = CompressionForFile(file_name);
     QFile csv_file(file_name);
-    if (!csv_file.open(QFile::WriteOnly | QFile::Text)) {
+    const QIODevice::OpenMode mode =
+        compression == Compression::kNone ? QFile::WriteOnly | QFile::Text : QFile::WriteOnly;
+    if (!csv_file.open(mode)) {
         QMessageBox msg;
         msg.setText("failed to open file");
         msg.exec();
         return;
     }
+    query.setForwardOnly(true);
+    ExportStats stats;
+    const Timer exec_timer;
     if (!query.exec()) {
         QMessageBox msg;
         msg.setText("failed to run query");
         msg.exec();
         return;
     }
-    QTextStream out_stream(&csv_file);
-    out_stream << header << "\n";
-    out_stream.setEncoding(QStringConverter::Utf8);
-    while (query.next()) {
-        const QSqlRecord record = query.record();
-        for (int i = 0, rec_count = record.count(); i < rec_count; ++i) {
-            if (i > 0) {
-                out_stream << ',';
-            }
-            out_stream << utils::csv::EscapeCSV(record.value(i).toString());
-        }
-        out_stream << '\n';
+    stats.exec = exec_timer.GetTimes().wall_time;
+    bool written = false;
+    if (compression == Compression::kNone) {
+        written = ExportQuery(header, query, csv_file, {}, stats);
+    } else {
+        CompressedDevice compressed(&csv_file, compression);
+        written = compressed.open(QIODevice::WriteOnly) &&
+                  ExportQuery(header, query, compressed, {}, stats);
+        compressed.close();
+        written = written && !compressed.HasError();
+    }
+    if (!written) {
+        QMessageBox msg;
+        msg.setText("failed to write file");
+        msg.exec();
+    } else if (on_stats) {
+        on_stats(stats);
+    }
+}
+
+void outfit::utils::csv::SaveQuery(const QString& header, const PartitionedExport& spec) {
+    SaveQuery(header, spec, {});
+}
+
+void outfit::utils::csv::SaveQuery(
+    const QString& header, const PartitionedExport& spec, const StatsCallback& on_stats) {
+    const QString file_name =
+        QFileDialog::getSaveFileName(nullptr, "export.csv", ".", "CSV (*.csv)");
+    if (file_name == "") {
+        return;
+    }
+    QFile csv_file(file_name);
+    if (!csv_file.open(QFile::WriteOnly | QFile::Text)) {
+        QMessageBox msg;
+        msg.setText("failed to open file");
+        msg.exec();
+        return;
+    }
+    ExportStats stats;
+    if (!ExportPartitioned(header, spec, csv_file, stats)) {
+        QMessageBox msg;
+        msg.setText("failed to export table");
+        msg.exec();
+    } else if (on_stats) {
+        on_stats(stats);
     }
 }
\ No newline at end of file
@@ -5,13 +5,23 @@
 #ifndef CREATIVE_CSV_H
 #define CREATIVE_CSV_H
 
+#include "csv_escape.h"
+#include "csv_partitioned.h"
+#include "csv_stats.h"
+
 #include <QSqlQuery>
 #include <QString>
 
+// Dialog front-ends over the export engine in :csv_core.
 namespace outfit::utils::csv {
-QString EscapeCSV(QString unexc);
-
 void SaveQuery(const QString& header, QSqlQuery& query);
+// Reports where the export spent its time once the file was written.
+void SaveQuery(const QString& header, QSqlQuery& query, const StatsCallback& on_stats);
+
+// Partitioned mode: exports a table split on a numeric key, see ExportPartitioned.
+void SaveQuery(const QString& header, const PartitionedExport& spec);
+void SaveQuery(
+    const QString& header, const PartitionedExport& spec, const StatsCallback& on_stats);
 }  // namespace outfit::utils::csv
 
 #endif  // CREATIVE_CSV_H
@@ -0,0 +1,317 @@
+#include "csv_escape.h"
+#include "csv_writer.h"
+#include "tools/util/util.h"
+
+#include <QCoreApplication>
+#include <QIODevice>
+#include <QLatin1Char>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QStringLiteral>
+#include <QVariant>
+#include <QVariantList>
+#include <QVector>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+enum ColumnKind : int64_t {
+    kIntegers,
+    kReals,
+    kText,
+    kMixed,
+};
+
+constexpr int kColumns = 4;
+constexpr int64_t kTextLength = 24;
+const QString kConnection = QStringLiteral("csv_benchmark");
+
+// Swallows the export so that only formatting is measured.
+class NullDevice : public QIODevice {
+   public:
+    NullDevice() {
+        open(QIODevice::WriteOnly);
+    }
+
+    [[nodiscard]] qint64 Written() const {
+        return written_;
+    }
+
+   protected:
+    qint64 readData(char* /*data*/, qint64 /*max_size*/) override {
+        return -1;
+    }
+
+    qint64 writeData(const char* /*data*/, qint64 size) override {
+        written_ += size;
+        return size;
+    }
+
+   private:
+    qint64 written_ = 0;
+};
+
+QString GenText(RandomGenerator& gen, int64_t escape_every) {
+    QString text = QString::fromStdString(gen.GenString(kTextLength));
+    if (escape_every > 0) {
+        for (auto& c : text) {
+            if (gen.GenInt<int64_t>(1, escape_every) == 1) {
+                c = gen.GenInt(0, 1) == 0 ? QLatin1Char(',') : QLatin1Char('"');
+            }
+        }
+    }
+    return text;
+}
+
+QString SqlType(ColumnKind kind, int column) {
+    if (kind == kMixed) {
+        kind = static_cast<ColumnKind>(column % 3);
+    }
+    switch (kind) {
+        case kIntegers:
+            return QStringLiteral("INTEGER");
+        case kReals:
+            return QStringLiteral("REAL");
+        default:
+            return QStringLiteral("TEXT");
+    }
+}
+
+void SkipWithError(benchmark::State& state, const QString& what, const QSqlError& error) {
+    const std::string message = (what + QStringLiteral(": ") + error.text()).toStdString();
+    state.SkipWithError(message.c_str());
+}
+
+struct SeedKey {
+    int64_t rows;
+    ColumnKind kind;
+    int64_t escape_every;
+
+    bool operator==(const SeedKey&) const = default;
+};
+
+// The table of the argument set that ran last. Google Benchmark calls a benchmark function
+// several times per argument set while it settles on the iteration count, and every call
+// would otherwise seed the table again.
+struct SeededDatabase {
+    std::optional<SeedKey> key;
+    QSqlDatabase db;
+};
+
+SeededDatabase& LastSeeded() {
+    static SeededDatabase seeded;
+    return seeded;
+}
+
+void DropSeededDatabase() {
+    LastSeeded() = {};
+    QSqlDatabase::removeDatabase(kConnection);
+}
+
+// Creates an in-memory SQLite table with kColumns columns of the given kind, or reuses it when
+// the previous call had the same arguments. Marks the benchmark as skipped and returns
+// nullopt if SQLite fails.
+std::optional<QSqlDatabase> SeedDatabase(
+    benchmark::State& state, int64_t rows, ColumnKind kind, int64_t escape_every) {
+    const SeedKey key{rows, kind, escape_every};
+    if (LastSeeded().key == key) {
+        return LastSeeded().db;
+    }
+    DropSeededDatabase();
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), kConnection);
+    db.setDatabaseName(QStringLiteral(":memory:"));
+    if (!db.open()) {
+        SkipWithError(state, QStringLiteral("failed to open SQLite"), db.lastError());
+        return std::nullopt;
+    }
+
+    QStringList definitions;
+    for (int i = 0; i < kColumns; ++i) {
+        definitions << QStringLiteral("c%1 %2").arg(i).arg(SqlType(kind, i));
+    }
+    QSqlQuery create(db);
+    if (!create.exec(QStringLiteral("CREATE TABLE items (%1)").arg(definitions.join(',')))) {
+        SkipWithError(state, QStringLiteral("failed to create the table"), create.lastError());
+        return std::nullopt;
+    }
+
+    RandomGenerator gen;
+    std::array<QVariantList, kColumns> columns;
+    for (int i = 0; i < kColumns; ++i) {
+        const QString type = SqlType(kind, i);
+        if (type == QStringLiteral("INTEGER")) {
+            constexpr auto kMin = std::numeric_limits<qint64>::min();
+            constexpr auto kMax = std::numeric_limits<qint64>::max();
+            for (const qint64 value : gen.GenIntegralVector<qint64>(rows, kMin, kMax)) {
+                columns[i] << QVariant::fromValue(value);
+            }
+        } else if (type == QStringLiteral("REAL")) {
+            for (const double value : gen.GenRealVector(rows, -1e9, 1e9)) {
+                columns[i] << value;
+            }
+        } else {
+            for (int64_t row = 0; row < rows; ++row) {
+                columns[i] << GenText(gen, escape_every);
+            }
+        }
+    }
+    db.transaction();
+    QSqlQuery insert(db);
+    insert.prepare(QStringLiteral("INSERT INTO items VALUES (?, ?, ?, ?)"));
+    for (const auto& column : columns) {
+        insert.addBindValue(column);
+    }
+    if (!insert.execBatch() || !db.commit()) {
+        SkipWithError(state, QStringLiteral("failed to seed the table"), insert.lastError());
+        return std::nullopt;
+    }
+    LastSeeded() = {key, db};
+    return db;
+}
+
+#ifdef __linux__
+// A field such as VmRSS or VmHWM of /proc/self/status in kB, or -1 if it is missing.
+int64_t ReadStatusKb(std::string_view field) {
+    std::ifstream in{"/proc/self/status"};
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.starts_with(field) && line.size() > field.size() && line[field.size()] == ':') {
+            return std::stoll(line.substr(field.size() + 1));
+        }
+    }
+    return -1;
+}
+#endif
+
+// How far the resident set grows above its size at construction, reported as the
+// peak_rss_growth_kb counter. The kernel's high-water mark, which ru_maxrss also reads, is
+// reset first (Linux 4.0 and later), so neither earlier benchmarks nor the seeded table count.
+class PeakRssGrowth {
+   public:
+    PeakRssGrowth() {
+#ifdef __linux__
+        std::ofstream clear_refs{"/proc/self/clear_refs"};
+        clear_refs << "5";
+        clear_refs.flush();
+        if (clear_refs) {
+            baseline_kb_ = ReadStatusKb("VmRSS");
+        }
+#endif
+    }
+
+    void Report(benchmark::State& state) const {
+#ifdef __linux__
+        const int64_t peak_kb = ReadStatusKb("VmHWM");
+        if (baseline_kb_ >= 0 && peak_kb >= 0) {
+            state.counters["peak_rss_growth_kb"] = static_cast<double>(peak_kb - baseline_kb_);
+        }
+#else
+        (void)state;
+#endif
+    }
+
+   private:
+    int64_t baseline_kb_ = -1;
+};
+
+void BM_EscapeCSV(benchmark::State& state) {
+    const auto db = SeedDatabase(state, state.range(0), kText, state.range(1));
+    if (!db) {
+        return;
+    }
+    QVector<QString> fields;
+    QSqlQuery query(*db);
+    if (!query.exec(QStringLiteral("SELECT * FROM items"))) {
+        SkipWithError(state, QStringLiteral("failed to read the table"), query.lastError());
+        return;
+    }
+    while (query.next()) {
+        for (int i = 0; i < kColumns; ++i) {
+            fields.push_back(query.value(i).toString());
+        }
+    }
+    const PeakRssGrowth memory;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        for (const auto& field : fields) {
+            const QString escaped = outfit::utils::csv::EscapeCSV(field);
+            bytes += escaped.size();
+            benchmark::DoNotOptimize(escaped);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fields.size());
+    state.SetBytesProcessed(bytes * 2);
+    memory.Report(state);
+}
+
+// SaveQuery is the dialog around ExportQuery, so the engine is measured directly.
+void BM_SaveQuery(benchmark::State& state) {
+    const auto kind = static_cast<ColumnKind>(state.range(1));
+    const auto db = SeedDatabase(state, state.range(0), kind, state.range(2));
+    if (!db) {
+        return;
+    }
+    const QString header = QStringLiteral("c0,c1,c2,c3");
+    const PeakRssGrowth memory;
+    int64_t bytes = 0;
+    for (auto _ : state) {
+        QSqlQuery query(*db);
+        query.setForwardOnly(true);
+        if (!query.exec(QStringLiteral("SELECT * FROM items"))) {
+            SkipWithError(state, QStringLiteral("failed to run the query"), query.lastError());
+            break;
+        }
+        NullDevice device;
+        if (!outfit::utils::csv::ExportQuery(header, query, device)) {
+            SkipWithError(state, QStringLiteral("export failed"), query.lastError());
+            break;
+        }
+        bytes += device.Written();
+    }
+    state.counters["rows/s"] = benchmark::Counter(
+        static_cast<double>(state.iterations() * state.range(0)), benchmark::Counter::kIsRate);
+    state.SetBytesProcessed(bytes);
+    memory.Report(state);
+}
+
+void EscapeArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"rows", "escape_every"});
+    for (const int64_t escape_every : {0, 64, 8}) {
+        bench->Args({10'000, escape_every});
+    }
+}
+
+void SaveQueryArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"rows", "kind", "escape_every"});
+    for (const int64_t rows : {10'000, 100'000}) {
+        for (const int64_t kind : {kIntegers, kReals, kText, kMixed}) {
+            bench->Args({rows, kind, 0});
+        }
+        bench->Args({rows, kText, 8});
+    }
+}
+}  // namespace
+
+BENCHMARK(BM_EscapeCSV)->Apply(EscapeArgs)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SaveQuery)->Apply(SaveQueryArgs)->Unit(benchmark::kMillisecond);
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    // The SQLite driver is a plugin, which needs an application instance to be found.
+    const QCoreApplication app(argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    DropSeededDatabase();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,451 @@
+#include "csv_columnar.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QDataStream>
+#include <QDate>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QIODevice>
+#include <QMetaType>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlField>
+#include <QSqlRecord>
+#include <QString>
+#include <QUtf8StringView>
+#include <QVariant>
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "columnar buffers are written in host order");
+
+namespace {
+using outfit::utils::csv::ColumnChunk;
+using outfit::utils::csv::ColumnEncoding;
+using outfit::utils::csv::ColumnSchema;
+using outfit::utils::csv::ColumnType;
+using outfit::utils::csv::kColumnarMagic;
+using outfit::utils::csv::kColumnarVersion;
+using outfit::utils::csv::RowGroup;
+
+constexpr qsizetype kHeaderSize = 64;
+constexpr qsizetype kBufferAlignment = 64;
+constexpr qsizetype kTrailerSize = sizeof(quint64) + kColumnarMagic.size();
+
+ColumnType TypeOf(QMetaType type) {
+    switch (type.id()) {
+        case QMetaType::Bool:
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return ColumnType::kInt64;
+        case QMetaType::Float:
+        case QMetaType::Double:
+            return ColumnType::kDouble;
+        case QMetaType::QDate:
+            return ColumnType::kDate;
+        case QMetaType::QDateTime:
+            return ColumnType::kDateTime;
+        default:
+            return ColumnType::kString;
+    }
+}
+
+template <class T>
+std::pair<const char*, qsizetype> Bytes(const std::vector<T>& values) {
+    return {reinterpret_cast<const char*>(values.data()),  // NOLINT
+            static_cast<qsizetype>(values.size() * sizeof(T))};
+}
+
+void WriteFooter(
+    QDataStream& out, const std::vector<ColumnSchema>& schema,
+    const std::vector<RowGroup>& groups) {
+    out << kColumnarVersion << static_cast<quint32>(schema.size());
+    for (const auto& column : schema) {
+        out << column.name.toUtf8() << static_cast<quint8>(column.type);
+    }
+    out << static_cast<quint64>(groups.size());
+    for (const auto& group : groups) {
+        out << group.rows;
+        for (const auto& chunk : group.columns) {
+            out << static_cast<quint8>(chunk.encoding) << chunk.dictionary_size;
+            for (const auto& range : chunk.buffers) {
+                out << range.offset << range.size;
+            }
+        }
+    }
+}
+
+// The smallest footer entries, used to bound counts read from the file before allocating.
+constexpr quint64 kMinColumnBytes = sizeof(quint32) + sizeof(quint8);
+constexpr quint64 kMinChunkBytes =
+    sizeof(quint8) + sizeof(quint64) + ColumnChunk::kBufferCount * 2 * sizeof(quint64);
+
+template <class T>
+bool IsArray(const ColumnChunk::Range& range, quint64 count) {
+    return range.offset % alignof(T) == 0 && range.size % sizeof(T) == 0 &&
+           range.size / sizeof(T) >= count;
+}
+
+// Offsets into the chunk's data buffer: count + 1 of them, ascending, within the buffer.
+bool AreOffsets(std::span<const char> data, const ColumnChunk& chunk, quint64 count) {
+    const auto& range = chunk.buffers[ColumnChunk::kOffsets];
+    if (!IsArray<quint64>(range, count + 1)) {
+        return false;
+    }
+    const std::span<const quint64> offsets{
+        reinterpret_cast<const quint64*>(data.data() + range.offset),  // NOLINT
+        static_cast<size_t>(count + 1)};
+    return std::ranges::is_sorted(offsets) &&
+           offsets.back() <= chunk.buffers[ColumnChunk::kData].size;
+}
+
+// Checks everything the reader's accessors rely on, so a corrupted file cannot make them
+// read outside the mapping or through a misaligned pointer.
+bool IsValidChunk(
+    std::span<const char> data, ColumnType type, const ColumnChunk& chunk, quint64 rows) {
+    if (chunk.buffers[ColumnChunk::kValidity].size < (rows + 7) / 8) {
+        return false;
+    }
+    const auto& values = chunk.buffers[ColumnChunk::kValues];
+    switch (type) {
+        case ColumnType::kInt64:
+        case ColumnType::kDate:
+        case ColumnType::kDateTime:
+            return IsArray<qint64>(values, rows);
+        case ColumnType::kDouble:
+            return IsArray<double>(values, rows);
+        case ColumnType::kString:
+            if (chunk.encoding == ColumnEncoding::kDictionary) {
+                return IsArray<quint32>(values, rows) &&
+                       AreOffsets(data, chunk, chunk.dictionary_size);
+            }
+            return AreOffsets(data, chunk, rows);
+    }
+    return false;
+}
+
+// data is the file up to the footer; footer_size bounds the counts read from the footer.
+bool ReadFooter(
+    QDataStream& in, std::span<const char> data, quint64 footer_size,
+    std::vector<ColumnSchema>& schema, std::vector<RowGroup>& groups) {
+    quint32 version = 0;
+    quint32 columns = 0;
+    in >> version >> columns;
+    if (version != kColumnarVersion || columns > footer_size / kMinColumnBytes) {
+        return false;
+    }
+    schema.resize(columns);
+    for (auto& column : schema) {
+        QByteArray name;
+        quint8 type = 0;
+        in >> name >> type;
+        if (type < static_cast<quint8>(ColumnType::kInt64) ||
+            type > static_cast<quint8>(ColumnType::kDateTime)) {
+            return false;
+        }
+        column = {QString::fromUtf8(name), static_cast<ColumnType>(type)};
+    }
+    quint64 group_count = 0;
+    in >> group_count;
+    if (in.status() != QDataStream::Ok ||
+        group_count > footer_size / (sizeof(quint64) + columns * kMinChunkBytes)) {
+        return false;
+    }
+    groups.clear();
+    for (quint64 g = 0; g < group_count && in.status() == QDataStream::Ok; ++g) {
+        RowGroup& group = groups.emplace_back();
+        in >> group.rows;
+        group.columns.resize(columns);
+        for (quint32 c = 0; c < columns; ++c) {
+            ColumnChunk& chunk = group.columns[c];
+            quint8 encoding = 0;
+            in >> encoding >> chunk.dictionary_size;
+            if (encoding > static_cast<quint8>(ColumnEncoding::kDictionary)) {
+                return false;
+            }
+            chunk.encoding = static_cast<ColumnEncoding>(encoding);
+            for (auto& range : chunk.buffers) {
+                in >> range.offset >> range.size;
+                if (range.offset > data.size() || range.size > data.size() - range.offset) {
+                    return false;
+                }
+            }
+            if (in.status() != QDataStream::Ok ||
+                !IsValidChunk(data, schema[c].type, chunk, group.rows)) {
+                return false;
+            }
+        }
+    }
+    return in.status() == QDataStream::Ok;
+}
+}  // namespace
+
+outfit::utils::csv::ColumnarWriter::ColumnarWriter(
+    QIODevice* device, const QSqlRecord& record, ColumnarOptions options)
+    : device_{device}, options_{options}, builders_(record.count()) {
+    for (int i = 0; i < record.count(); ++i) {
+        const QSqlField field = record.field(i);
+        schema_.push_back({field.name(), TypeOf(field.metaType())});
+    }
+    QByteArray header(kHeaderSize, '\0');
+    std::memcpy(header.data(), kColumnarMagic.data(), kColumnarMagic.size());
+    qToLittleEndian(kColumnarVersion, header.data() + kColumnarMagic.size());
+    Write(header.constData(), header.size());
+}
+
+void outfit::utils::csv::ColumnarWriter::WriteRow(const QSqlQuery& query) {
+    const qint64 row = group_rows_;
+    for (int i = 0; i < static_cast<int>(schema_.size()); ++i) {
+        Builder& builder = builders_[i];
+        if (row % 8 == 0) {
+            builder.validity.append('\0');
+        }
+        const QVariant value = query.value(i);
+        bool valid = !value.isNull();
+        switch (schema_[i].type) {
+            case ColumnType::kInt64:
+                builder.integers.push_back(valid ? value.toLongLong(&valid) : 0);
+                break;
+            case ColumnType::kDouble:
+                builder.reals.push_back(valid ? value.toDouble(&valid) : 0.);
+                break;
+            case ColumnType::kDate: {
+                const QDate date = value.toDate();
+                valid = valid && date.isValid();
+                builder.integers.push_back(valid ? date.toJulianDay() : 0);
+                break;
+            }
+            case ColumnType::kDateTime: {
+                const QDateTime date_time = value.toDateTime();
+                valid = valid && date_time.isValid();
+                builder.integers.push_back(valid ? date_time.toMSecsSinceEpoch() : 0);
+                break;
+            }
+            case ColumnType::kString:
+                if (valid) {
+                    builder.data += value.toString().toUtf8();
+                }
+                builder.offsets.push_back(builder.data.size());
+                break;
+        }
+        if (valid) {
+            builder.validity.back() = static_cast<char>(builder.validity.back() | (1 << (row % 8)));
+        }
+    }
+    if (++group_rows_ == options_.rows_per_group) {
+        FlushGroup();
+    }
+}
+
+bool outfit::utils::csv::ColumnarWriter::Finish() {
+    if (group_rows_ != 0) {
+        FlushGroup();
+    }
+    Pad(kBufferAlignment);
+    const quint64 footer_offset = offset_;
+    QByteArray footer;
+    {
+        QDataStream out(&footer, QIODevice::WriteOnly);
+        // The format is versioned by kColumnarVersion, not by the Qt that wrote it.
+        out.setVersion(QDataStream::Qt_6_0);
+        out.setByteOrder(QDataStream::LittleEndian);
+        WriteFooter(out, schema_, groups_);
+    }
+    Write(footer.constData(), footer.size());
+    char trailer[kTrailerSize];  // NOLINT(*-avoid-c-arrays)
+    qToLittleEndian(footer_offset, trailer);
+    std::memcpy(trailer + sizeof(quint64), kColumnarMagic.data(), kColumnarMagic.size());
+    Write(trailer, kTrailerSize);
+    return !has_error_;
+}
+
+void outfit::utils::csv::ColumnarWriter::FlushGroup() {
+    RowGroup group;
+    group.rows = group_rows_;
+    group_rows_ = 0;
+    for (qsizetype i = 0; i < static_cast<qsizetype>(schema_.size()); ++i) {
+        group.columns.push_back(WriteChunk(schema_[i], builders_[i]));
+        builders_[i] = Builder{};
+    }
+    groups_.push_back(std::move(group));
+}
+
+ColumnChunk outfit::utils::csv::ColumnarWriter::WriteChunk(
+    const ColumnSchema& column, Builder& builder) {
+    ColumnChunk chunk;
+    chunk.buffers[ColumnChunk::kValidity] =
+        WriteBuffer(builder.validity.constData(), builder.validity.size());
+    switch (column.type) {
+        case ColumnType::kInt64:
+        case ColumnType::kDate:
+        case ColumnType::kDateTime: {
+            const auto [data, size] = Bytes(builder.integers);
+            chunk.buffers[ColumnChunk::kValues] = WriteBuffer(data, size);
+            break;
+        }
+        case ColumnType::kDouble: {
+            const auto [data, size] = Bytes(builder.reals);
+            chunk.buffers[ColumnChunk::kValues] = WriteBuffer(data, size);
+            break;
+        }
+        case ColumnType::kString: {
+            const auto rows = static_cast<qsizetype>(builder.offsets.size()) - 1;
+            if (options_.dictionary_strings) {
+                QHash<QByteArrayView, quint32> index;
+                std::vector<quint32> codes;
+                std::vector<quint64> offsets{0};
+                QByteArray entries;
+                codes.reserve(rows);
+                for (qsizetype row = 0; row < rows && index.size() * 2 <= rows; ++row) {
+                    const QByteArrayView value(
+                        builder.data.constData() + builder.offsets[row],
+                        static_cast<qsizetype>(builder.offsets[row + 1] - builder.offsets[row]));
+                    auto it = index.constFind(value);
+                    if (it == index.constEnd()) {
+                        it = index.insert(value, static_cast<quint32>(index.size()));
+                        entries.append(value);
+                        offsets.push_back(entries.size());
+                    }
+                    codes.push_back(*it);
+                }
+                if (index.size() * 2 <= rows) {
+                    chunk.encoding = ColumnEncoding::kDictionary;
+                    chunk.dictionary_size = index.size();
+                    const auto [code_data, code_size] = Bytes(codes);
+                    chunk.buffers[ColumnChunk::kValues] = WriteBuffer(code_data, code_size);
+                    const auto [offset_data, offset_size] = Bytes(offsets);
+                    chunk.buffers[ColumnChunk::kOffsets] = WriteBuffer(offset_data, offset_size);
+                    chunk.buffers[ColumnChunk::kData] =
+                        WriteBuffer(entries.constData(), entries.size());
+                    break;
+                }
+            }
+            const auto [offset_data, offset_size] = Bytes(builder.offsets);
+            chunk.buffers[ColumnChunk::kOffsets] = WriteBuffer(offset_data, offset_size);
+            chunk.buffers[ColumnChunk::kData] =
+                WriteBuffer(builder.data.constData(), builder.data.size());
+            break;
+        }
+    }
+    return chunk;
+}
+
+ColumnChunk::Range outfit::utils::csv::ColumnarWriter::WriteBuffer(
+    const char* data, qsizetype size) {
+    Pad(kBufferAlignment);
+    const ColumnChunk::Range range{offset_, static_cast<quint64>(size)};
+    Write(data, size);
+    return range;
+}
+
+void outfit::utils::csv::ColumnarWriter::Pad(qsizetype alignment) {
+    static constexpr char kZeros[kBufferAlignment] = {};  // NOLINT(*-avoid-c-arrays)
+    if (const auto rest = static_cast<qsizetype>(offset_ % alignment); rest != 0) {
+        Write(kZeros, alignment - rest);
+    }
+}
+
+void outfit::utils::csv::ColumnarWriter::Write(const char* data, qsizetype size) {
+    if (size == 0 || has_error_) {
+        return;
+    }
+    if (device_->write(data, size) != size) {
+        has_error_ = true;
+    }
+    offset_ += size;
+}
+
+bool outfit::utils::csv::ExportQueryColumnar(
+    QSqlQuery& query, QIODevice& device, const ColumnarOptions& options) {
+    // Keeps drivers from caching the whole result set.
+    query.setForwardOnly(true);
+    if (!query.exec()) {
+        return false;
+    }
+    ColumnarWriter writer(&device, query.record(), options);
+    while (query.next()) {
+        writer.WriteRow(query);
+    }
+    // next() also returns false when fetching fails; a footer over the rows read so far would
+    // make the truncated file look complete.
+    if (query.lastError().isValid()) {
+        return false;
+    }
+    return writer.Finish();
+}
+
+bool outfit::utils::csv::ColumnarReader::Open(const QString& file_name) {
+    file_.close();
+    file_.setFileName(file_name);
+    if (!file_.open(QFile::ReadOnly) || file_.size() < kHeaderSize + kTrailerSize) {
+        return false;
+    }
+    const auto size = static_cast<quint64>(file_.size());
+    const auto* mapped = reinterpret_cast<const char*>(file_.map(0, file_.size()));  // NOLINT
+    if (mapped == nullptr) {
+        return false;
+    }
+    data_ = {mapped, size};
+    const char* trailer = mapped + size - kTrailerSize;
+    if (std::memcmp(mapped, kColumnarMagic.data(), kColumnarMagic.size()) != 0 ||
+        std::memcmp(trailer + sizeof(quint64), kColumnarMagic.data(), kColumnarMagic.size()) !=
+            0) {
+        return false;
+    }
+    const auto footer_offset = qFromLittleEndian<quint64>(trailer);
+    if (footer_offset < kHeaderSize || footer_offset > size - kTrailerSize) {
+        return false;
+    }
+    const QByteArray footer = QByteArray::fromRawData(
+        mapped + footer_offset, static_cast<qsizetype>(size - kTrailerSize - footer_offset));
+    QDataStream in(footer);
+    in.setVersion(QDataStream::Qt_6_0);
+    in.setByteOrder(QDataStream::LittleEndian);
+    return ReadFooter(
+        in, data_.first(footer_offset), static_cast<quint64>(footer.size()), schema_, groups_);
+}
+
+bool outfit::utils::csv::ColumnarReader::IsNull(
+    qsizetype group, qsizetype column, quint64 row) const {
+    const auto validity = Buffer<uchar>(group, column, ColumnChunk::kValidity);
+    return row / 8 >= validity.size() || (validity[row / 8] & (1U << (row % 8))) == 0;
+}
+
+std::span<const qint64> outfit::utils::csv::ColumnarReader::Int64Values(
+    qsizetype group, qsizetype column) const {
+    return Buffer<qint64>(group, column, ColumnChunk::kValues);
+}
+
+std::span<const double> outfit::utils::csv::ColumnarReader::DoubleValues(
+    qsizetype group, qsizetype column) const {
+    return Buffer<double>(group, column, ColumnChunk::kValues);
+}
+
+std::span<const quint32> outfit::utils::csv::ColumnarReader::Codes(
+    qsizetype group, qsizetype column) const {
+    return Buffer<quint32>(group, column, ColumnChunk::kValues);
+}
+
+QUtf8StringView outfit::utils::csv::ColumnarReader::String(
+    qsizetype group, qsizetype column, quint64 index) const {
+    const auto offsets = Buffer<quint64>(group, column, ColumnChunk::kOffsets);
+    const auto data = Buffer<char>(group, column, ColumnChunk::kData);
+    if (index + 1 >= offsets.size()) {
+        return {};
+    }
+    return {
+        data.data() + offsets[index], static_cast<qsizetype>(offsets[index + 1] - offsets[index])};
+}
@@ -0,0 +1,159 @@
+#ifndef CREATIVE_CSV_COLUMNAR_H
+#define CREATIVE_CSV_COLUMNAR_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QIODevice>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QUtf8StringView>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Binary columnar export. A file is a 64-byte header, a sequence of row groups and a footer:
+//
+//   header:    magic "OFCOLv1\0", version (u32), padding
+//   row group: for every column, 64-byte aligned buffers:
+//              validity bitmap (bit i set when row i is not NULL), then
+//              kInt64/kDate/kDateTime: i64 per row, kDouble: f64 per row,
+//              kString plain:      u64 offsets[rows + 1], UTF-8 bytes
+//              kString dictionary: u32 codes per row, u64 offsets[size + 1], UTF-8 bytes
+//   footer:    schema and the offsets of every buffer (little endian QDataStream)
+//   trailer:   footer offset (u64), magic
+//
+// All values are little endian, so a mapped file is read in place.
+namespace outfit::utils::csv {
+enum class ColumnType : quint8 {
+    kInt64 = 1,
+    kDouble = 2,
+    kString = 3,
+    // Julian day number.
+    kDate = 4,
+    // Milliseconds since the Unix epoch, UTC.
+    kDateTime = 5,
+};
+
+enum class ColumnEncoding : quint8 {
+    kPlain = 0,
+    kDictionary = 1,
+};
+
+inline constexpr std::array<char, 8> kColumnarMagic = {'O', 'F', 'C', 'O', 'L', 'v', '1', '\0'};
+inline constexpr quint32 kColumnarVersion = 1;
+
+struct ColumnarOptions {
+    qint64 rows_per_group = qint64{1} << 16;
+    // Dictionary-encode string chunks with at most half as many distinct values as rows.
+    bool dictionary_strings = true;
+};
+
+struct ColumnSchema {
+    QString name;
+    ColumnType type = ColumnType::kString;
+};
+
+struct ColumnChunk {
+    enum Buffer : quint8 { kValidity, kValues, kOffsets, kData, kBufferCount };
+
+    struct Range {
+        quint64 offset = 0;
+        quint64 size = 0;
+    };
+
+    ColumnEncoding encoding = ColumnEncoding::kPlain;
+    quint64 dictionary_size = 0;
+    std::array<Range, kBufferCount> buffers{};
+};
+
+struct RowGroup {
+    quint64 rows = 0;
+    std::vector<ColumnChunk> columns;
+};
+
+// Accumulates a row group per column and writes it once it is full.
+class ColumnarWriter {
+   public:
+    ColumnarWriter(QIODevice* device, const QSqlRecord& record, ColumnarOptions options = {});
+
+    void WriteRow(const QSqlQuery& query);
+    // Writes the last row group and the footer.
+    bool Finish();
+
+    [[nodiscard]] const std::vector<ColumnSchema>& Schema() const {
+        return schema_;
+    }
+
+   private:
+    struct Builder {
+        QByteArray validity;
+        std::vector<qint64> integers;
+        std::vector<double> reals;
+        std::vector<quint64> offsets{0};
+        QByteArray data;
+    };
+
+    void FlushGroup();
+    ColumnChunk WriteChunk(const ColumnSchema& column, Builder& builder);
+    ColumnChunk::Range WriteBuffer(const char* data, qsizetype size);
+    void Pad(qsizetype alignment);
+    void Write(const char* data, qsizetype size);
+
+    QIODevice* device_;
+    ColumnarOptions options_;
+    std::vector<ColumnSchema> schema_;
+    std::vector<Builder> builders_;
+    std::vector<RowGroup> groups_;
+    qint64 group_rows_ = 0;
+    quint64 offset_ = 0;
+    bool has_error_ = false;
+};
+
+// Runs the prepared query forward-only, like SaveQuery, and writes every row. Returns false if
+// the query fails, also in the middle of the result, or on a write error.
+bool ExportQueryColumnar(QSqlQuery& query, QIODevice& device, const ColumnarOptions& options = {});
+
+// Maps a columnar file and exposes its buffers without copying or parsing them.
+class ColumnarReader {
+   public:
+    bool Open(const QString& file_name);
+
+    [[nodiscard]] const std::vector<ColumnSchema>& Schema() const {
+        return schema_;
+    }
+
+    [[nodiscard]] const std::vector<RowGroup>& RowGroups() const {
+        return groups_;
+    }
+
+    [[nodiscard]] bool IsNull(qsizetype group, qsizetype column, quint64 row) const;
+    [[nodiscard]] std::span<const qint64> Int64Values(qsizetype group, qsizetype column) const;
+    [[nodiscard]] std::span<const double> DoubleValues(qsizetype group, qsizetype column) const;
+    // Dictionary codes of a kDictionary string chunk.
+    [[nodiscard]] std::span<const quint32> Codes(qsizetype group, qsizetype column) const;
+    // The index-th string of a plain chunk, or the index-th dictionary entry.
+    [[nodiscard]] QUtf8StringView String(qsizetype group, qsizetype column, quint64 index) const;
+
+   private:
+    template <class T>
+    std::span<const T> Buffer(qsizetype group, qsizetype column, ColumnChunk::Buffer buffer) const {
+        const auto range = groups_[group].columns[column].buffers[buffer];
+        // Open() checks the buffers each column type uses; others may not fit T.
+        if (range.offset % alignof(T) != 0) {
+            return {};
+        }
+        return {reinterpret_cast<const T*>(data_.data() + range.offset),  // NOLINT
+                range.size / sizeof(T)};
+    }
+
+    QFile file_;
+    std::span<const char> data_;
+    std::vector<ColumnSchema> schema_;
+    std::vector<RowGroup> groups_;
+};
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_COLUMNAR_H
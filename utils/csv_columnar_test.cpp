@@ -0,0 +1,162 @@
+#include "csv_columnar.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringLiteral>
+#include <QTemporaryDir>
+#include <QVariant>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+using outfit::utils::csv::ColumnarReader;
+using outfit::utils::csv::ColumnEncoding;
+using outfit::utils::csv::ColumnType;
+
+const QString kConnection = QStringLiteral("csv_columnar_test");
+constexpr int kRows = 250;
+
+struct Row {
+    std::optional<qint64> id;
+    std::optional<double> price;
+    // Few distinct values, so it is dictionary-encoded when allowed.
+    std::optional<QString> category;
+    // Distinct in every row, so it is always plain.
+    QString name;
+};
+
+Row MakeRow(int row) {
+    Row result;
+    if (row % 11 != 5) {
+        result.id = (qint64{1} << 40) * (row % 2 == 0 ? 1 : -1) + row;
+    }
+    if (row % 13 != 7) {
+        result.price = row * 0.25 - 17.;
+    }
+    if (row % 17 != 0) {
+        result.category = QStringLiteral("category \u00e9 %1").arg(row % 4);
+    }
+    result.name = QStringLiteral("name, \"%1\"").arg(row);
+    return result;
+}
+
+QVariant ToVariant(const auto& value) {
+    return value ? QVariant(*value) : QVariant();
+}
+
+QString WriteFile(const QTemporaryDir& dir, const outfit::utils::csv::ColumnarOptions& options) {
+    QSqlDatabase::removeDatabase(kConnection);
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), kConnection);
+    db.setDatabaseName(QStringLiteral(":memory:"));
+    REQUIRE(db.open());
+    REQUIRE(QSqlQuery(db).exec(
+        QStringLiteral("CREATE TABLE items (id INTEGER, price REAL, category TEXT, name TEXT)")));
+    QSqlQuery insert(db);
+    REQUIRE(insert.prepare(QStringLiteral("INSERT INTO items VALUES (?, ?, ?, ?)")));
+    for (int i = 0; i < kRows; ++i) {
+        const Row row = MakeRow(i);
+        insert.addBindValue(ToVariant(row.id));
+        insert.addBindValue(ToVariant(row.price));
+        insert.addBindValue(ToVariant(row.category));
+        insert.addBindValue(row.name);
+        REQUIRE(insert.exec());
+    }
+
+    const QString file_name = dir.filePath(QStringLiteral("items.ofcol"));
+    QFile file(file_name);
+    REQUIRE(file.open(QFile::WriteOnly));
+    QSqlQuery query(db);
+    REQUIRE(query.prepare(QStringLiteral("SELECT * FROM items ORDER BY rowid")));
+    REQUIRE(outfit::utils::csv::ExportQueryColumnar(query, file, options));
+    return file_name;
+}
+
+QString ReadString(const ColumnarReader& reader, qsizetype group, qsizetype column, int row) {
+    const auto& chunk = reader.RowGroups()[group].columns[column];
+    const quint64 index = chunk.encoding == ColumnEncoding::kDictionary
+                              ? reader.Codes(group, column)[row]
+                              : static_cast<quint64>(row);
+    return reader.String(group, column, index).toString();
+}
+}  // namespace
+
+TEST_CASE("ColumnarReader reads back what ExportQueryColumnar wrote") {
+    const QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    for (const bool dictionary_strings : {false, true}) {
+        CAPTURE(dictionary_strings);
+        // Two full row groups and a partial one.
+        const QString file_name =
+            WriteFile(dir, {.rows_per_group = 100, .dictionary_strings = dictionary_strings});
+        ColumnarReader reader;
+        REQUIRE(reader.Open(file_name));
+
+        const auto& schema = reader.Schema();
+        REQUIRE(schema.size() == 4);
+        CHECK(schema[0].name == QStringLiteral("id"));
+        CHECK(schema[0].type == ColumnType::kInt64);
+        CHECK(schema[1].type == ColumnType::kDouble);
+        CHECK(schema[2].type == ColumnType::kString);
+        CHECK(schema[3].type == ColumnType::kString);
+
+        const auto& groups = reader.RowGroups();
+        REQUIRE(groups.size() == 3);
+        CHECK(groups[0].rows == 100);
+        CHECK(groups[2].rows == 50);
+        CHECK(groups[0].columns[2].encoding ==
+              (dictionary_strings ? ColumnEncoding::kDictionary : ColumnEncoding::kPlain));
+        CHECK(groups[0].columns[3].encoding == ColumnEncoding::kPlain);
+
+        int first_row = 0;
+        for (qsizetype group = 0; group < static_cast<qsizetype>(groups.size()); ++group) {
+            const auto ids = reader.Int64Values(group, 0);
+            const auto prices = reader.DoubleValues(group, 1);
+            REQUIRE(ids.size() == groups[group].rows);
+            REQUIRE(prices.size() == groups[group].rows);
+            for (int row = 0; std::cmp_less(row, groups[group].rows); ++row) {
+                const Row expected = MakeRow(first_row + row);
+                CAPTURE(group, row);
+                REQUIRE(reader.IsNull(group, 0, row) == !expected.id);
+                if (expected.id) {
+                    CHECK(ids[row] == *expected.id);
+                }
+                REQUIRE(reader.IsNull(group, 1, row) == !expected.price);
+                if (expected.price) {
+                    CHECK(prices[row] == *expected.price);
+                }
+                REQUIRE(reader.IsNull(group, 2, row) == !expected.category);
+                if (expected.category) {
+                    CHECK(ReadString(reader, group, 2, row) == *expected.category);
+                }
+                CHECK_FALSE(reader.IsNull(group, 3, row));
+                CHECK(ReadString(reader, group, 3, row) == expected.name);
+            }
+            first_row += static_cast<int>(groups[group].rows);
+        }
+        CHECK(first_row == kRows);
+    }
+}
+
+TEST_CASE("ColumnarReader rejects a truncated file") {
+    const QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString file_name = WriteFile(dir, {});
+    QFile file(file_name);
+    REQUIRE(file.open(QFile::ReadWrite));
+    const QByteArray contents = file.readAll();
+    // Keeps the trailer, so only the footer offset gives the damage away.
+    const QByteArray truncated = contents.left(64) + contents.right(contents.size() / 2);
+    REQUIRE(file.resize(0));
+    REQUIRE(file.write(truncated) == truncated.size());
+    file.close();
+
+    ColumnarReader reader;
+    CHECK_FALSE(reader.Open(file_name));
+}
@@ -0,0 +1,169 @@
+#include "csv_compress.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QStringLiteral>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include <zlib.h>
+#ifdef OUTFIT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+using outfit::utils::csv::Compression;
+
+constexpr int kGzipLevel = 6;
+constexpr int kZstdLevel = 3;
+// Window bits of 15 plus 16 makes deflate write a gzip header and trailer.
+constexpr int kGzipWindowBits = 15 + 16;
+constexpr int kMemLevel = 8;
+
+QByteArray Gzip(const QByteArray& input) {
+    z_stream stream{};
+    if (deflateInit2(
+            &stream, kGzipLevel, Z_DEFLATED, kGzipWindowBits, kMemLevel, Z_DEFAULT_STRATEGY) !=
+        Z_OK) {
+        return {};
+    }
+    QByteArray output(
+        static_cast<qsizetype>(deflateBound(&stream, input.size())), Qt::Uninitialized);
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.constData()));  // NOLINT
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(output.data());  // NOLINT
+    stream.avail_out = static_cast<uInt>(output.size());
+    const int status = deflate(&stream, Z_FINISH);
+    output.resize(static_cast<qsizetype>(stream.total_out));
+    deflateEnd(&stream);
+    return status == Z_STREAM_END ? output : QByteArray{};
+}
+
+#ifdef OUTFIT_HAVE_ZSTD
+QByteArray Zstd(const QByteArray& input) {
+    QByteArray output(
+        static_cast<qsizetype>(ZSTD_compressBound(input.size())), Qt::Uninitialized);
+    const size_t size =
+        ZSTD_compress(output.data(), output.size(), input.constData(), input.size(), kZstdLevel);
+    if (ZSTD_isError(size) != 0) {
+        return {};
+    }
+    output.resize(static_cast<qsizetype>(size));
+    return output;
+}
+#endif
+
+QByteArray Compress(Compression compression, const QByteArray& input) {
+    switch (compression) {
+        case Compression::kGzip:
+            return Gzip(input);
+#ifdef OUTFIT_HAVE_ZSTD
+        case Compression::kZstd:
+            return Zstd(input);
+#endif
+        default:
+            return input;
+    }
+}
+}  // namespace
+
+bool outfit::utils::csv::IsCompressionAvailable(Compression compression) {
+#ifndef OUTFIT_HAVE_ZSTD
+    if (compression == Compression::kZstd) {
+        return false;
+    }
+#endif
+    return true;
+}
+
+outfit::utils::csv::Compression outfit::utils::csv::CompressionForFile(const QString& file_name) {
+    if (file_name.endsWith(QStringLiteral(".gz"))) {
+        return Compression::kGzip;
+    }
+    if (file_name.endsWith(QStringLiteral(".zst"))) {
+        return Compression::kZstd;
+    }
+    return Compression::kNone;
+}
+
+outfit::utils::csv::CompressedDevice::CompressedDevice(
+    QIODevice* target, Compression compression, int threads, qsizetype block_size)
+    : target_{target}, compression_{compression}, block_size_{block_size} {
+    pool_.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+    pending_.reserve(block_size_);
+}
+
+outfit::utils::csv::CompressedDevice::~CompressedDevice() {
+    close();
+}
+
+bool outfit::utils::csv::CompressedDevice::open(OpenMode mode) {
+    if ((mode & ReadOnly) != 0 || compression_ == Compression::kNone ||
+        !IsCompressionAvailable(compression_)) {
+        return false;
+    }
+    has_blocks_ = false;
+    has_error_ = false;
+    return QIODevice::open(mode);
+}
+
+void outfit::utils::csv::CompressedDevice::close() {
+    if (!isOpen()) {
+        return;
+    }
+    // An empty stream still needs one member/frame to be a valid compressed file.
+    if (!pending_.isEmpty() || !has_blocks_) {
+        SubmitBlock();
+    }
+    while (!in_flight_.empty()) {
+        WriteOldestBlock();
+    }
+    QIODevice::close();
+}
+
+qint64 outfit::utils::csv::CompressedDevice::readData(char* /*data*/, qint64 /*max_size*/) {
+    return -1;
+}
+
+qint64 outfit::utils::csv::CompressedDevice::writeData(const char* data, qint64 size) {
+    if (has_error_) {
+        return -1;
+    }
+    qint64 written = 0;
+    while (written < size) {
+        const qint64 chunk = std::min<qint64>(size - written, block_size_ - pending_.size());
+        pending_.append(data + written, chunk);
+        written += chunk;
+        if (pending_.size() == block_size_) {
+            SubmitBlock();
+        }
+    }
+    return has_error_ ? -1 : written;
+}
+
+void outfit::utils::csv::CompressedDevice::SubmitBlock() {
+    // Bound memory: keep at most two blocks per worker in flight.
+    while (static_cast<int>(in_flight_.size()) >= 2 * pool_.maxThreadCount()) {
+        WriteOldestBlock();
+    }
+    auto promise = std::make_shared<std::promise<QByteArray>>();
+    in_flight_.push_back(promise->get_future());
+    pool_.start([promise, compression = compression_, block = std::move(pending_)] {
+        promise->set_value(Compress(compression, block));
+    });
+    pending_ = QByteArray{};
+    pending_.reserve(block_size_);
+    has_blocks_ = true;
+}
+
+void outfit::utils::csv::CompressedDevice::WriteOldestBlock() {
+    const QByteArray block = in_flight_.front().get();
+    in_flight_.pop_front();
+    if (block.isEmpty() || target_->write(block) != block.size()) {
+        has_error_ = true;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef CREATIVE_CSV_COMPRESS_H
+#define CREATIVE_CSV_COMPRESS_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QThreadPool>
+
+#include <deque>
+#include <future>
+
+namespace outfit::utils::csv {
+enum class Compression {
+    kNone,
+    kGzip,
+    // Only available when built with zstd (--//utils:zstd, on by default).
+    kZstd,
+};
+
+bool IsCompressionAvailable(Compression compression);
+
+// Picks the compression from the file suffix: .gz or .zst.
+Compression CompressionForFile(const QString& file_name);
+
+// Write-only device that cuts the stream into independent blocks and compresses them on a
+// thread pool while the caller keeps writing. Each block becomes a complete gzip member or
+// zstd frame and blocks are written to the target in order, so the output is an ordinary
+// .gz / .zst file.
+class CompressedDevice : public QIODevice {
+   public:
+    static constexpr qsizetype kDefaultBlockSize = qsizetype{4} << 20;
+
+    CompressedDevice(
+        QIODevice* target, Compression compression, int threads = 0,
+        qsizetype block_size = kDefaultBlockSize);
+    ~CompressedDevice() override;
+
+    CompressedDevice(const CompressedDevice&) = delete;
+    CompressedDevice& operator=(const CompressedDevice&) = delete;
+    CompressedDevice(CompressedDevice&&) = delete;
+    CompressedDevice& operator=(CompressedDevice&&) = delete;
+
+    bool open(OpenMode mode) override;
+    // Compresses the last block and waits until everything is written to the target.
+    void close() override;
+
+    [[nodiscard]] bool isSequential() const override {
+        return true;
+    }
+
+    [[nodiscard]] bool HasError() const {
+        return has_error_;
+    }
+
+   protected:
+    qint64 readData(char* data, qint64 max_size) override;
+    qint64 writeData(const char* data, qint64 size) override;
+
+   private:
+    void SubmitBlock();
+    void WriteOldestBlock();
+
+    QIODevice* target_;
+    Compression compression_;
+    qsizetype block_size_;
+    QByteArray pending_;
+    QThreadPool pool_;
+    std::deque<std::future<QByteArray>> in_flight_;
+    bool has_blocks_ = false;
+    bool has_error_ = false;
+};
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_COMPRESS_H
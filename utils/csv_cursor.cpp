@@ -0,0 +1,178 @@
+#include "csv_cursor.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringLiteral>
+#include <QVariant>
+
+#include <mutex>
+#include <utility>
+
+void outfit::utils::csv::RowBatch::Append(const QSqlQuery& query) {
+    const auto offset = static_cast<size_t>(rows_ * columns_);
+    if (values_.size() < offset + columns_) {
+        values_.resize(offset + columns_);
+    }
+    for (int i = 0; i < columns_; ++i) {
+        values_[offset + i] = query.value(i);
+    }
+    ++rows_;
+}
+
+void outfit::utils::csv::RowBatch::Clear(int columns) {
+    rows_ = 0;
+    columns_ = columns;
+}
+
+outfit::utils::csv::QueryCursor::QueryCursor(QSqlQuery& query, qsizetype batch_rows)
+    : query_{query}, batch_rows_{batch_rows} {
+    if (!query_.isActive()) {
+        query_.setForwardOnly(true);
+    }
+}
+
+QSqlRecord outfit::utils::csv::QueryCursor::Record() const {
+    return query_.record();
+}
+
+bool outfit::utils::csv::QueryCursor::Next(RowBatch& batch) {
+    batch.Clear(query_.record().count());
+    while (batch.Rows() < batch_rows_ && query_.next()) {
+        batch.Append(query_);
+    }
+    return batch.Rows() > 0;
+}
+
+QString outfit::utils::csv::QueryCursor::Error() const {
+    // next() returns false both at the end and on a fetch error; only the latter sets it.
+    const QSqlError error = query_.lastError();
+    return error.isValid() ? error.text() : QString();
+}
+
+outfit::utils::csv::PrefetchingCursor::PrefetchingCursor(
+    QString connection_name, QString sql, QVariantList bound_values, qsizetype batch_rows)
+    : connection_name_{std::move(connection_name)}
+    , sql_{std::move(sql)}
+    , bound_values_{std::move(bound_values)}
+    , batch_rows_{batch_rows}
+    , spare_(2) {
+}
+
+outfit::utils::csv::PrefetchingCursor::~PrefetchingCursor() {
+    {
+        const std::lock_guard lock{mutex_};
+        stop_ = true;
+    }
+    changed_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool outfit::utils::csv::PrefetchingCursor::Start() {
+    thread_ = std::thread([this] { Run(); });
+    std::unique_lock lock{mutex_};
+    changed_.wait(lock, [this] { return started_; });
+    return error_.isEmpty();
+}
+
+QSqlRecord outfit::utils::csv::PrefetchingCursor::Record() const {
+    const std::lock_guard lock{mutex_};
+    return record_;
+}
+
+QString outfit::utils::csv::PrefetchingCursor::Error() const {
+    const std::lock_guard lock{mutex_};
+    return error_;
+}
+
+bool outfit::utils::csv::PrefetchingCursor::Next(RowBatch& batch) {
+    std::unique_lock lock{mutex_};
+    // The batch handed out last time is free again; give its buffer back to the helper.
+    spare_.push_back(std::move(batch));
+    changed_.notify_all();
+    changed_.wait(lock, [this] { return ready_.has_value() || finished_; });
+    if (!ready_) {
+        batch = std::move(spare_.back());
+        spare_.pop_back();
+        batch.Clear(0);
+        return false;
+    }
+    batch = std::move(*ready_);
+    ready_.reset();
+    changed_.notify_all();
+    return true;
+}
+
+void outfit::utils::csv::PrefetchingCursor::Run() {
+    const QString connection =
+        QStringLiteral("outfit_csv_cursor_%1")
+            .arg(reinterpret_cast<quintptr>(this), 0, 16);  // NOLINT(*-reinterpret-cast)
+    {
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(connection_name_, connection);
+        QSqlQuery query(db);
+        QString error;
+        if (!db.open()) {
+            error = db.lastError().text();
+        } else {
+            query.setForwardOnly(true);
+            query.prepare(sql_);
+            for (const QVariant& value : std::as_const(bound_values_)) {
+                query.addBindValue(value);
+            }
+            if (!query.exec()) {
+                error = query.lastError().text();
+            }
+        }
+        {
+            const std::lock_guard lock{mutex_};
+            started_ = true;
+            finished_ = !error.isEmpty();
+            error_ = error;
+            record_ = query.record();
+        }
+        changed_.notify_all();
+
+        const int columns = record_.count();
+        while (error.isEmpty()) {
+            RowBatch batch;
+            {
+                std::unique_lock lock{mutex_};
+                changed_.wait(lock, [this] { return !spare_.empty() || stop_; });
+                if (stop_) {
+                    break;
+                }
+                batch = std::move(spare_.back());
+                spare_.pop_back();
+            }
+            batch.Clear(columns);
+            while (batch.Rows() < batch_rows_ && query.next()) {
+                batch.Append(query);
+            }
+            const bool last = batch.Rows() == 0;
+            std::unique_lock lock{mutex_};
+            if (batch.Rows() < batch_rows_ && query.lastError().isValid()) {
+                error_ = query.lastError().text();
+            }
+            if (last) {
+                spare_.push_back(std::move(batch));
+                break;
+            }
+            changed_.wait(lock, [this] { return !ready_.has_value() || stop_; });
+            if (stop_) {
+                break;
+            }
+            ready_ = std::move(batch);
+            changed_.notify_all();
+        }
+    }
+    QSqlDatabase::removeDatabase(connection);
+    {
+        const std::lock_guard lock{mutex_};
+        finished_ = true;
+    }
+    changed_.notify_all();
+}
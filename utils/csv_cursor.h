@@ -0,0 +1,136 @@
+#ifndef CREATIVE_CSV_CURSOR_H
+#define CREATIVE_CSV_CURSOR_H
+
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace outfit::utils::csv {
+// Rows of a result set stored row-major in a buffer that is reused between batches.
+class RowBatch {
+   public:
+    [[nodiscard]] qsizetype Rows() const {
+        return rows_;
+    }
+
+    [[nodiscard]] const QVariant& Value(qsizetype row, int column) const {
+        return values_[row * columns_ + column];
+    }
+
+    // Copies the current row of the query, growing the buffer only on the first batch.
+    void Append(const QSqlQuery& query);
+    void Clear(int columns);
+
+    // Drops the rows for which remove(row) is true and keeps the others in order.
+    template <class Predicate>
+    void RemoveRowsIf(const Predicate& remove) {
+        qsizetype kept = 0;
+        for (qsizetype row = 0; row < rows_; ++row) {
+            if (remove(row)) {
+                continue;
+            }
+            if (kept != row) {
+                const auto from = values_.begin() + row * columns_;
+                std::move(from, from + columns_, values_.begin() + kept * columns_);
+            }
+            ++kept;
+        }
+        rows_ = kept;
+    }
+
+   private:
+    std::vector<QVariant> values_;
+    qsizetype rows_ = 0;
+    int columns_ = 0;
+};
+
+inline constexpr qsizetype kDefaultBatchRows = 1024;
+
+// Forward-only source of row batches. Memory stays bounded by a few batches regardless of
+// the size of the result set.
+class RowCursor {
+   public:
+    RowCursor() = default;
+    virtual ~RowCursor() = default;
+
+    RowCursor(const RowCursor&) = delete;
+    RowCursor& operator=(const RowCursor&) = delete;
+    RowCursor(RowCursor&&) = delete;
+    RowCursor& operator=(RowCursor&&) = delete;
+
+    [[nodiscard]] virtual QSqlRecord Record() const = 0;
+    // Replaces the batch contents with the next rows; returns false once none are left.
+    virtual bool Next(RowBatch& batch) = 0;
+    // Empty unless Next() stopped because of an error rather than the end of the rows.
+    [[nodiscard]] virtual QString Error() const = 0;
+};
+
+// Reads batches synchronously from a caller-owned query. The query is switched to
+// forward-only if it has not been executed yet, so drivers do not cache the result set.
+class QueryCursor : public RowCursor {
+   public:
+    explicit QueryCursor(QSqlQuery& query, qsizetype batch_rows = kDefaultBatchRows);
+
+    [[nodiscard]] QSqlRecord Record() const override;
+    bool Next(RowBatch& batch) override;
+    [[nodiscard]] QString Error() const override;
+
+   private:
+    QSqlQuery& query_;
+    qsizetype batch_rows_;
+};
+
+// Runs the query on a helper thread with its own clone of the connection and fetches the
+// next batch there while the caller formats the current one. Qt connections may only be
+// used from the thread that opened them, which is why the helper owns one instead of
+// sharing the caller's query. At most three batches exist at a time.
+class PrefetchingCursor : public RowCursor {
+   public:
+    PrefetchingCursor(
+        QString connection_name, QString sql, QVariantList bound_values,
+        qsizetype batch_rows = kDefaultBatchRows);
+    ~PrefetchingCursor() override;
+
+    PrefetchingCursor(const PrefetchingCursor&) = delete;
+    PrefetchingCursor& operator=(const PrefetchingCursor&) = delete;
+    PrefetchingCursor(PrefetchingCursor&&) = delete;
+    PrefetchingCursor& operator=(PrefetchingCursor&&) = delete;
+
+    // Opens the connection and executes the query; on failure Error() says why.
+    bool Start();
+
+    [[nodiscard]] QSqlRecord Record() const override;
+    bool Next(RowBatch& batch) override;
+    [[nodiscard]] QString Error() const override;
+
+   private:
+    void Run();
+
+    QString connection_name_;
+    QString sql_;
+    QVariantList bound_values_;
+    qsizetype batch_rows_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    bool started_ = false;
+    bool finished_ = false;
+    bool stop_ = false;
+    QString error_;
+    QSqlRecord record_;
+    std::optional<RowBatch> ready_;
+    std::vector<RowBatch> spare_;
+    std::thread thread_;
+};
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_CURSOR_H
@@ -0,0 +1,204 @@
+#include "csv_escape.h"
+
+#include <QChar>
+#include <QLatin1Char>
+#include <QString>
+#include <QStringView>
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define OUTFIT_CSV_HAS_SSE2 1
+#if defined(__GNUC__)
+#define OUTFIT_CSV_HAS_AVX2 1
+#endif
+#endif
+
+namespace {
+using outfit::utils::csv::FieldClass;
+
+constexpr bool IsSpecial(char16_t c) {
+    return c == u',' || c == u'"' || c == u'\n' || c == u'\r';
+}
+
+qsizetype FindSpecialTail(const char* data, qsizetype size) {
+    for (qsizetype i = 0; i < size; ++i) {
+        if (IsSpecial(static_cast<unsigned char>(data[i]))) {
+            return i;
+        }
+    }
+    return size;
+}
+
+void ClassifyTail(const char16_t* data, qsizetype size, FieldClass& result) {
+    for (qsizetype i = 0; i < size; ++i) {
+        result.needs_quoting |= IsSpecial(data[i]);
+        result.quotes += static_cast<qsizetype>(data[i] == u'"');
+    }
+}
+
+#ifdef OUTFIT_CSV_HAS_SSE2
+FieldClass ClassifySse2(const char16_t* data, qsizetype size) {
+    const __m128i comma = _mm_set1_epi16(',');
+    const __m128i quote = _mm_set1_epi16('"');
+    const __m128i lf = _mm_set1_epi16('\n');
+    const __m128i cr = _mm_set1_epi16('\r');
+    FieldClass result;
+    unsigned special = 0;
+    qsizetype i = 0;
+    for (; i + 8 <= size; i += 8) {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));  // NOLINT
+        const __m128i quotes = _mm_cmpeq_epi16(chunk, quote);
+        const __m128i breaks =
+            _mm_or_si128(_mm_cmpeq_epi16(chunk, lf), _mm_cmpeq_epi16(chunk, cr));
+        const __m128i any =
+            _mm_or_si128(_mm_or_si128(quotes, breaks), _mm_cmpeq_epi16(chunk, comma));
+        special |= static_cast<unsigned>(_mm_movemask_epi8(any));
+        // Each matching 16-bit lane sets two mask bits.
+        result.quotes += std::popcount(static_cast<unsigned>(_mm_movemask_epi8(quotes))) / 2;
+    }
+    result.needs_quoting = special != 0;
+    ClassifyTail(data + i, size - i, result);
+    return result;
+}
+
+qsizetype FindSpecialSse2(const char* data, qsizetype size) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    qsizetype i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i chunk =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));  // NOLINT
+        const __m128i any = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, comma), _mm_cmpeq_epi8(chunk, quote)),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)));
+        if (const auto mask = static_cast<unsigned>(_mm_movemask_epi8(any)); mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + FindSpecialTail(data + i, size - i);
+}
+#endif
+
+#ifdef OUTFIT_CSV_HAS_AVX2
+__attribute__((target("avx2"))) FieldClass ClassifyAvx2(const char16_t* data, qsizetype size) {
+    const __m256i comma = _mm256_set1_epi16(',');
+    const __m256i quote = _mm256_set1_epi16('"');
+    const __m256i lf = _mm256_set1_epi16('\n');
+    const __m256i cr = _mm256_set1_epi16('\r');
+    FieldClass result;
+    unsigned special = 0;
+    qsizetype i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));  // NOLINT
+        const __m256i quotes = _mm256_cmpeq_epi16(chunk, quote);
+        const __m256i breaks =
+            _mm256_or_si256(_mm256_cmpeq_epi16(chunk, lf), _mm256_cmpeq_epi16(chunk, cr));
+        const __m256i any =
+            _mm256_or_si256(_mm256_or_si256(quotes, breaks), _mm256_cmpeq_epi16(chunk, comma));
+        special |= static_cast<unsigned>(_mm256_movemask_epi8(any));
+        result.quotes += std::popcount(static_cast<unsigned>(_mm256_movemask_epi8(quotes))) / 2;
+    }
+    result.needs_quoting = special != 0;
+    ClassifyTail(data + i, size - i, result);
+    return result;
+}
+
+__attribute__((target("avx2"))) qsizetype FindSpecialAvx2(const char* data, qsizetype size) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    qsizetype i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i chunk =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));  // NOLINT
+        const __m256i any = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, comma), _mm256_cmpeq_epi8(chunk, quote)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, lf), _mm256_cmpeq_epi8(chunk, cr)));
+        if (const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(any)); mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + FindSpecialSse2(data + i, size - i);
+}
+
+bool HasAvx2() {
+    static const bool kHasAvx2 = __builtin_cpu_supports("avx2") != 0;
+    return kHasAvx2;
+}
+#endif
+}  // namespace
+
+outfit::utils::csv::FieldClass outfit::utils::csv::ClassifyField(QStringView field) {
+    const char16_t* data = field.utf16();
+    const qsizetype size = field.size();
+#ifdef OUTFIT_CSV_HAS_AVX2
+    if (size >= 16 && HasAvx2()) {
+        return ClassifyAvx2(data, size);
+    }
+#endif
+#ifdef OUTFIT_CSV_HAS_SSE2
+    return ClassifySse2(data, size);
+#else
+    FieldClass result;
+    ClassifyTail(data, size, result);
+    return result;
+#endif
+}
+
+QString outfit::utils::csv::EscapeCSV(QString unexc) {
+    const FieldClass field_class = ClassifyField(unexc);
+    if (!field_class.needs_quoting) {
+        return unexc;
+    }
+    QString escaped(EscapedSize(unexc, field_class), Qt::Uninitialized);
+    EscapeCSV(unexc, field_class, escaped.data());
+    return escaped;
+}
+
+qsizetype outfit::utils::csv::EscapeCSV(QStringView field, FieldClass field_class, QChar* out) {
+    if (!field_class.needs_quoting) {
+        std::copy(field.begin(), field.end(), out);
+        return field.size();
+    }
+    QChar* const begin = out;
+    *out++ = QLatin1Char('"');
+    if (field_class.quotes == 0) {
+        out = std::copy(field.begin(), field.end(), out);
+    } else {
+        const QChar* current = field.begin();
+        const QChar* const end = field.end();
+        while (current != end) {
+            const QChar* quote = std::find(current, end, QLatin1Char('"'));
+            out = std::copy(current, quote, out);
+            if (quote == end) {
+                break;
+            }
+            *out++ = QLatin1Char('"');
+            *out++ = QLatin1Char('"');
+            current = quote + 1;
+        }
+    }
+    *out++ = QLatin1Char('"');
+    return out - begin;
+}
+
+qsizetype outfit::utils::csv::FindSpecial(const char* data, qsizetype size) {
+#ifdef OUTFIT_CSV_HAS_AVX2
+    if (size >= 32 && HasAvx2()) {
+        return FindSpecialAvx2(data, size);
+    }
+#endif
+#ifdef OUTFIT_CSV_HAS_SSE2
+    return FindSpecialSse2(data, size);
+#else
+    return FindSpecialTail(data, size);
+#endif
+}
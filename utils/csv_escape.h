@@ -0,0 +1,33 @@
+#ifndef CREATIVE_CSV_ESCAPE_H
+#define CREATIVE_CSV_ESCAPE_H
+
+#include <QChar>
+#include <QString>
+#include <QStringView>
+
+namespace outfit::utils::csv {
+struct FieldClass {
+    bool needs_quoting = false;
+    qsizetype quotes = 0;
+};
+
+// Classifies a field in a single vectorized pass: RFC 4180 requires quoting when the field
+// contains a comma, a double quote, CR or LF, and every double quote is doubled inside.
+FieldClass ClassifyField(QStringView field);
+
+inline qsizetype EscapedSize(QStringView field, FieldClass field_class) {
+    return field_class.needs_quoting ? field.size() + field_class.quotes + 2 : field.size();
+}
+
+QString EscapeCSV(QString unexc);
+
+// Writes the escaped form of the field into out, which must hold at least
+// EscapedSize(field, field_class) characters. Returns the number of characters written.
+qsizetype EscapeCSV(QStringView field, FieldClass field_class, QChar* out);
+
+// Returns the offset of the first comma, double quote, CR or LF in UTF-8 data, or size if
+// there is none. Used by the loader to split records.
+qsizetype FindSpecial(const char* data, qsizetype size);
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_ESCAPE_H
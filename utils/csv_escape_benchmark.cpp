@@ -0,0 +1,91 @@
+#include "csv_escape.h"
+#include "tools/util/util.h"
+
+#include <QLatin1Char>
+#include <QString>
+#include <QStringLiteral>
+#include <QVector>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <utility>
+
+namespace {
+// The implementation EscapeCSV had before the vectorized classifier, kept as the baseline.
+QString LegacyEscapeCSV(QString unexc) {
+    if (!unexc.contains(QLatin1Char(','))) {
+        return unexc;
+    }
+    return '\"' + unexc.replace(QLatin1Char('\"'), QStringLiteral("\"\"")) + '\"';
+}
+
+// Fields of the given length where roughly one character in escape_every is a comma or quote.
+QVector<QString> MakeFields(int64_t length, int64_t escape_every) {
+    constexpr int kFields = 1024;
+    RandomGenerator gen;
+    QVector<QString> fields;
+    fields.reserve(kFields);
+    for (int i = 0; i < kFields; ++i) {
+        QString field = QString::fromStdString(gen.GenString(length));
+        for (auto& c : field) {
+            if (escape_every > 0 && gen.GenInt<int64_t>(1, escape_every) == 1) {
+                c = gen.GenInt(0, 1) == 0 ? QLatin1Char(',') : QLatin1Char('"');
+            }
+        }
+        fields.push_back(std::move(field));
+    }
+    return fields;
+}
+
+void SetCounters(benchmark::State& state, const QVector<QString>& fields) {
+    state.SetItemsProcessed(state.iterations() * fields.size());
+    state.SetBytesProcessed(state.iterations() * fields.size() * state.range(0) * 2);
+}
+
+void BM_LegacyEscapeCSV(benchmark::State& state) {
+    const auto fields = MakeFields(state.range(0), state.range(1));
+    for (auto _ : state) {
+        for (const auto& field : fields) {
+            benchmark::DoNotOptimize(LegacyEscapeCSV(field));
+        }
+    }
+    SetCounters(state, fields);
+}
+
+void BM_EscapeCSV(benchmark::State& state) {
+    const auto fields = MakeFields(state.range(0), state.range(1));
+    for (auto _ : state) {
+        for (const auto& field : fields) {
+            benchmark::DoNotOptimize(outfit::utils::csv::EscapeCSV(field));
+        }
+    }
+    SetCounters(state, fields);
+}
+
+void BM_EscapeCSVIntoBuffer(benchmark::State& state) {
+    const auto fields = MakeFields(state.range(0), state.range(1));
+    QString buffer(state.range(0) * 2 + 2, Qt::Uninitialized);
+    for (auto _ : state) {
+        for (const auto& field : fields) {
+            const auto field_class = outfit::utils::csv::ClassifyField(field);
+            benchmark::DoNotOptimize(
+                outfit::utils::csv::EscapeCSV(field, field_class, buffer.data()));
+        }
+    }
+    SetCounters(state, fields);
+}
+
+void EscapeArgs(benchmark::internal::Benchmark* bench) {
+    bench->ArgNames({"len", "escape_every"});
+    for (const int64_t length : {8, 64, 512}) {
+        for (const int64_t escape_every : {0, 64, 8}) {
+            bench->Args({length, escape_every});
+        }
+    }
+}
+}  // namespace
+
+BENCHMARK(BM_LegacyEscapeCSV)->Apply(EscapeArgs);
+BENCHMARK(BM_EscapeCSV)->Apply(EscapeArgs);
+BENCHMARK(BM_EscapeCSVIntoBuffer)->Apply(EscapeArgs);
@@ -0,0 +1,91 @@
+#include "csv_escape.h"
+
+#include <QByteArray>
+#include <QChar>
+#include <QLatin1Char>
+#include <QString>
+#include <QStringLiteral>
+
+#include <catch2/catch_test_macros.hpp>
+
+namespace {
+// Long enough for two AVX2 blocks (16 UTF-16 or 32 UTF-8 units) plus a tail of every length.
+constexpr qsizetype kMaxLength = 72;
+
+QString ReferenceEscape(const QString& field) {
+    if (!field.contains(u',') && !field.contains(u'"') && !field.contains(u'\n') &&
+        !field.contains(u'\r')) {
+        return field;
+    }
+    QString escaped = field;
+    escaped.replace(QStringLiteral("\""), QStringLiteral("\"\""));
+    return QStringLiteral("\"%1\"").arg(escaped);
+}
+
+void CheckEscape(const QString& field) {
+    const QString expected = ReferenceEscape(field);
+    CHECK(outfit::utils::csv::EscapeCSV(field) == expected);
+
+    const auto field_class = outfit::utils::csv::ClassifyField(field);
+    QString out(outfit::utils::csv::EscapedSize(field, field_class), Qt::Uninitialized);
+    CHECK(outfit::utils::csv::EscapeCSV(field, field_class, out.data()) == expected.size());
+    CHECK(out == expected);
+}
+}  // namespace
+
+TEST_CASE("EscapeCSV finds a special character at every position") {
+    for (qsizetype length = 1; length <= kMaxLength; ++length) {
+        for (qsizetype position = 0; position < length; ++position) {
+            for (const char16_t special : {u',', u'"', u'\n', u'\r'}) {
+                QString field(length, QLatin1Char('a'));
+                field[position] = QChar(special);
+                CAPTURE(length, position, static_cast<int>(special));
+                CheckEscape(field);
+            }
+        }
+    }
+}
+
+TEST_CASE("EscapeCSV counts every quote") {
+    for (qsizetype length = 0; length <= kMaxLength; ++length) {
+        CAPTURE(length);
+        CheckEscape(QString(length, QLatin1Char('"')));
+        QString alternating;
+        for (qsizetype i = 0; i < length; ++i) {
+            alternating += i % 3 == 0 ? QLatin1Char('"') : QLatin1Char('x');
+        }
+        CheckEscape(alternating);
+    }
+}
+
+TEST_CASE("EscapeCSV leaves plain fields alone") {
+    // Each of these has a special character in one of its bytes, which a byte-wise compare
+    // would mistake for a comma, a quote or a line break.
+    for (const char16_t wide : {u'\u2c2c', u'\u222c', u'\u0a0d', u'\u0d22'}) {
+        for (qsizetype length = 0; length <= kMaxLength; ++length) {
+            const QString field(length, QChar(wide));
+            CAPTURE(length, static_cast<int>(wide));
+            CHECK(outfit::utils::csv::EscapeCSV(field) == field);
+            CHECK_FALSE(outfit::utils::csv::ClassifyField(field).needs_quoting);
+        }
+    }
+}
+
+TEST_CASE("FindSpecial returns the first special byte") {
+    for (qsizetype length = 0; length <= kMaxLength; ++length) {
+        // Non-ASCII UTF-8: every byte has the high bit set and never matches.
+        const QByteArray plain = QString(length, QChar(u'\u00e9')).toUtf8().left(length);
+        CAPTURE(length);
+        CHECK(outfit::utils::csv::FindSpecial(plain.data(), plain.size()) == length);
+        for (qsizetype position = 0; position < length; ++position) {
+            for (const char special : {',', '"', '\n', '\r'}) {
+                QByteArray data(length, 'a');
+                data[position] = special;
+                // A later special character must not be reported instead.
+                data[length - 1] = ',';
+                CAPTURE(position, static_cast<int>(special));
+                CHECK(outfit::utils::csv::FindSpecial(data.data(), data.size()) == position);
+            }
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#include "csv_export_job.h"
+
+#include "csv_cursor.h"
+#include "csv_writer.h"
+#include "tools/util/util.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+#include <QThread>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+constexpr qint64 kProgressPeriodMs = 100;
+}  // namespace
+
+outfit::utils::csv::ExportJob::ExportJob(ExportRequest request, QObject* parent)
+    : QObject{parent}, request_{std::move(request)} {
+}
+
+outfit::utils::csv::ExportJob::~ExportJob() {
+    Cancel();
+    if (thread_ != nullptr) {
+        thread_->wait();
+    }
+}
+
+void outfit::utils::csv::ExportJob::Start() {
+    if (IsRunning()) {
+        return;
+    }
+    delete thread_;
+    cancel_requested_ = false;
+    thread_ = QThread::create([this] { Run(); });
+    thread_->setParent(this);
+    thread_->start();
+}
+
+void outfit::utils::csv::ExportJob::Cancel() {
+    cancel_requested_ = true;
+}
+
+bool outfit::utils::csv::ExportJob::IsRunning() const {
+    return thread_ != nullptr && thread_->isRunning();
+}
+
+outfit::utils::csv::ExportStats outfit::utils::csv::ExportJob::Stats() const {
+    return stats_;
+}
+
+void outfit::utils::csv::ExportJob::Run() {
+    QString error;
+    bool canceled = false;
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    PrefetchingCursor cursor(request_.connection_name, request_.sql, request_.bound_values);
+    QSaveFile csv_file(request_.file_name);
+    const Timer exec_timer;
+    const bool started = cursor.Start();
+    stats_ = {};
+    stats_.exec = exec_timer.GetTimes().wall_time;
+    if (!started) {
+        error = cursor.Error();
+    } else if (!csv_file.open(QFile::WriteOnly | QFile::Text)) {
+        error = csv_file.errorString();
+    } else {
+        QElapsedTimer timer;
+        timer.start();
+        qint64 last_report_ms = -kProgressPeriodMs;
+        const auto progress = [&](const ExportProgress& current) {
+            rows = current.rows;
+            bytes = current.bytes;
+            if (const qint64 elapsed_ms = timer.elapsed();
+                elapsed_ms - last_report_ms >= kProgressPeriodMs) {
+                last_report_ms = elapsed_ms;
+                const double seconds = std::max<double>(elapsed_ms, 1) / 1000.;
+                emit Progress(rows, bytes);
+                emit Throughput(rows / seconds, bytes / seconds);
+            }
+            return !cancel_requested_;
+        };
+        if (ExportCursor(request_.header, cursor, csv_file, progress, stats_)) {
+            if (!csv_file.commit()) {
+                error = csv_file.errorString();
+            }
+        } else if (!cursor.Error().isEmpty()) {
+            error = cursor.Error();
+        } else if (cancel_requested_) {
+            canceled = true;
+        } else {
+            error = csv_file.errorString();
+        }
+    }
+
+    if (canceled) {
+        emit Canceled();
+    } else if (!error.isEmpty()) {
+        emit Failed(error);
+    } else {
+        emit Progress(rows, bytes);
+        emit Finished(rows, bytes);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef CREATIVE_CSV_EXPORT_JOB_H
+#define CREATIVE_CSV_EXPORT_JOB_H
+
+#include "csv_stats.h"
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVariantList>
+
+#include <atomic>
+
+namespace outfit::utils::csv {
+struct ExportRequest {
+    // Name of an existing QSqlDatabase connection; the job clones it for its fetch thread,
+    // so in-memory databases are not shared with the clone.
+    QString connection_name;
+    QString sql;
+    QVariantList bound_values;
+    QString header;
+    QString file_name;
+};
+
+// Runs a CSV export on a worker thread; rows are fetched by a PrefetchingCursor on a second
+// thread with its own clone of the database connection. Signals are delivered to the thread
+// the job lives in and progress is throttled, so a GUI stays responsive for the whole export.
+// The file is replaced only if the export succeeds.
+class ExportJob : public QObject {
+    Q_OBJECT
+
+   public:
+    explicit ExportJob(ExportRequest request, QObject* parent = nullptr);
+    ~ExportJob() override;
+
+    ExportJob(const ExportJob&) = delete;
+    ExportJob& operator=(const ExportJob&) = delete;
+    ExportJob(ExportJob&&) = delete;
+    ExportJob& operator=(ExportJob&&) = delete;
+
+    void Start();
+    void Cancel();
+
+    [[nodiscard]] bool IsRunning() const;
+    // Valid once Finished, Failed or Canceled was emitted; exec covers opening the cloned
+    // connection and running the query.
+    [[nodiscard]] ExportStats Stats() const;
+
+   signals:
+    void Progress(qint64 rows, qint64 bytes);
+    void Throughput(double rows_per_second, double bytes_per_second);
+    void Finished(qint64 rows, qint64 bytes);
+    void Failed(const QString& error);
+    void Canceled();
+
+   private:
+    void Run();
+
+    ExportRequest request_;
+    QThread* thread_ = nullptr;
+    std::atomic<bool> cancel_requested_ = false;
+    ExportStats stats_;
+};
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_EXPORT_JOB_H
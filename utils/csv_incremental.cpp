@@ -0,0 +1,362 @@
+#include "csv_incremental.h"
+
+#include "csv_compress.h"
+#include "csv_cursor.h"
+#include "csv_writer.h"
+#include "tools/util/util.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QLatin1Char>
+#include <QMetaType>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringList>
+#include <QStringLiteral>
+#include <QVariant>
+
+#include <optional>
+#include <utility>
+
+namespace {
+using outfit::utils::csv::Compression;
+using outfit::utils::csv::ExportProgress;
+using outfit::utils::csv::ExportStats;
+using outfit::utils::csv::IncrementalExport;
+using outfit::utils::csv::ProgressCallback;
+using outfit::utils::csv::RowBatch;
+using outfit::utils::csv::RowCursor;
+
+struct SavedWatermark {
+    QString column;
+    QVariant value;
+    // RowHash of every exported row whose column equals value. Rows added later with the
+    // same value are exported by the next run; these are the ones it skips.
+    QStringList last_rows;
+};
+
+QString WatermarkFileName(const QString& file_name) {
+    return file_name + QStringLiteral(".watermark.json");
+}
+
+// A missing file is not an error: the target has not been exported yet.
+std::optional<SavedWatermark> LoadWatermark(const QString& file_name) {
+    QFile file(WatermarkFileName(file_name));
+    if (!file.exists()) {
+        return SavedWatermark{};
+    }
+    if (!file.open(QFile::ReadOnly)) {
+        return std::nullopt;
+    }
+    QJsonParseError error{};
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        return std::nullopt;
+    }
+    const QJsonObject object = document.object();
+    const QMetaType type =
+        QMetaType::fromName(object[QStringLiteral("type")].toString().toLatin1());
+    QVariant value(object[QStringLiteral("value")].toString());
+    if (!type.isValid() || !value.convert(type)) {
+        return std::nullopt;
+    }
+    QStringList last_rows;
+    for (const auto& hash : object[QStringLiteral("last_rows")].toArray()) {
+        last_rows << hash.toString();
+    }
+    return SavedWatermark{
+        object[QStringLiteral("column")].toString(), std::move(value), std::move(last_rows)};
+}
+
+// The value is stored as text with its type name so 64-bit keys and timestamps round-trip
+// exactly, which a JSON number would not guarantee.
+bool SaveWatermark(const QString& file_name, const QString& column, const QVariant& value,
+                   const QStringList& last_rows) {
+    QJsonObject object;
+    object[QStringLiteral("column")] = column;
+    object[QStringLiteral("type")] = QString::fromLatin1(value.metaType().name());
+    object[QStringLiteral("value")] = value.toString();
+    object[QStringLiteral("last_rows")] = QJsonArray::fromStringList(last_rows);
+    QSaveFile file(WatermarkFileName(file_name));
+    return file.open(QFile::WriteOnly) &&
+           file.write(QJsonDocument(object).toJson()) != -1 && file.commit();
+}
+
+// items.csv.gz -> items.20261018T120000123Z.csv.gz, or items.20261018T120000123Z-2.csv.gz
+// and so on if that exists already. An existing delta is never replaced: the watermark has
+// moved past its rows.
+QString DeltaFileName(const QString& file_name, const QDateTime& now) {
+    const QFileInfo info(file_name);
+    const QString stem = info.baseName() + QLatin1Char('.') +
+                         now.toString(QStringLiteral("yyyyMMdd'T'HHmmsszzz'Z'"));
+    const QString suffix = info.completeSuffix().isEmpty()
+                               ? QString()
+                               : QLatin1Char('.') + info.completeSuffix();
+    QString name = info.dir().filePath(stem + suffix);
+    for (int copy = 2; QFileInfo::exists(name); ++copy) {
+        name = info.dir().filePath(stem + QLatin1Char('-') + QString::number(copy) + suffix);
+    }
+    return name;
+}
+
+// Identifies a row by its contents. Values are length-prefixed, with -1 for NULL, so
+// different rows cannot concatenate to the same bytes.
+QString RowHash(const RowBatch& batch, qsizetype row, int columns) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (int column = 0; column < columns; ++column) {
+        const QVariant& value = batch.Value(row, column);
+        const QByteArray text = value.isNull() ? QByteArray() : value.toString().toUtf8();
+        const qint64 size = value.isNull() ? -1 : text.size();
+        hash.addData(QByteArrayView(
+            reinterpret_cast<const char*>(&size), sizeof(size)));  // NOLINT(*-reinterpret-cast)
+        hash.addData(text);
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+// Drops the rows the previous run already exported, remembers the watermark of the last row
+// handed out and the rows sharing it, and reads the first batch ahead, so no output is
+// created when nothing is new.
+class WatermarkCursor : public RowCursor {
+   public:
+    WatermarkCursor(RowCursor& source, int column, const SavedWatermark& saved)
+        : source_{source}
+        , column_{column}
+        , columns_{source.Record().count()}
+        , saved_value_{saved.value}
+        , last_{saved.value}
+        , last_rows_{saved.last_rows} {
+        for (const QString& hash : saved.last_rows) {
+            ++exported_[hash];
+        }
+    }
+
+    [[nodiscard]] QSqlRecord Record() const override {
+        return source_.Record();
+    }
+
+    [[nodiscard]] QString Error() const override {
+        return source_.Error();
+    }
+
+    bool Next(RowBatch& batch) override {
+        if (pending_) {
+            std::swap(batch, *pending_);
+            pending_.reset();
+            return true;
+        }
+        return Fetch(batch);
+    }
+
+    // Reads the first batch ahead; call before the first Next().
+    bool Empty() {
+        pending_.emplace();
+        if (!Fetch(*pending_)) {
+            pending_.reset();
+        }
+        return !pending_;
+    }
+
+    [[nodiscard]] const QVariant& Last() const {
+        return last_;
+    }
+
+    [[nodiscard]] const QStringList& LastRows() const {
+        return last_rows_;
+    }
+
+   private:
+    bool Fetch(RowBatch& batch) {
+        while (source_.Next(batch)) {
+            if (!exported_.isEmpty()) {
+                batch.RemoveRowsIf([this, &batch](qsizetype row) { return Exported(batch, row); });
+            }
+            if (batch.Rows() == 0) {
+                continue;
+            }
+            // Rows come in watermark order, so the ones sharing the last value are at the end.
+            if (const QVariant& value = batch.Value(batch.Rows() - 1, column_); value != last_) {
+                last_ = value;
+                last_rows_.clear();
+            }
+            qsizetype first = batch.Rows();
+            while (first > 0 && batch.Value(first - 1, column_) == last_) {
+                --first;
+            }
+            for (qsizetype row = first; row < batch.Rows(); ++row) {
+                last_rows_ << RowHash(batch, row, columns_);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Each saved hash skips one row, so identical rows added later are still exported.
+    bool Exported(const RowBatch& batch, qsizetype row) {
+        if (batch.Value(row, column_) != saved_value_) {
+            // Past the saved value; nothing further can have been exported.
+            exported_.clear();
+            return false;
+        }
+        const auto it = exported_.find(RowHash(batch, row, columns_));
+        if (it == exported_.end()) {
+            return false;
+        }
+        if (--*it == 0) {
+            exported_.erase(it);
+        }
+        return true;
+    }
+
+    RowCursor& source_;
+    int column_;
+    int columns_;
+    QVariant saved_value_;
+    QHash<QString, int> exported_;
+    std::optional<RowBatch> pending_;
+    QVariant last_;
+    QStringList last_rows_;
+};
+
+bool WriteRows(
+    const QString& header, bool write_header, RowCursor& cursor, QIODevice& device,
+    Compression compression, const ProgressCallback& progress, ExportStats& stats) {
+    if (compression == Compression::kNone) {
+        return outfit::utils::csv::ExportCursor(
+            header, write_header, cursor, device, progress, stats);
+    }
+    outfit::utils::csv::CompressedDevice compressed(&device, compression);
+    const bool written = compressed.open(QIODevice::WriteOnly) &&
+                         outfit::utils::csv::ExportCursor(
+                             header, write_header, cursor, compressed, progress, stats);
+    compressed.close();
+    return written && !compressed.HasError();
+}
+
+bool ExecuteDelta(const IncrementalExport& spec, const QVariant& watermark, QSqlQuery& query) {
+    const QSqlDriver& driver = *query.driver();
+    const QString column = driver.escapeIdentifier(spec.watermark_column, QSqlDriver::FieldName);
+    const QString sql =
+        QStringLiteral("SELECT * FROM (%1) AS outfit_source WHERE %2 %3 ORDER BY %2")
+            .arg(spec.sql, column,
+                 watermark.isNull() ? QStringLiteral("IS NOT NULL") : QStringLiteral(">= ?"));
+    query.setForwardOnly(true);
+    if (!query.prepare(sql)) {
+        return false;
+    }
+    for (const QVariant& value : spec.bound_values) {
+        query.addBindValue(value);
+    }
+    if (!watermark.isNull()) {
+        query.addBindValue(watermark);
+    }
+    return query.exec();
+}
+}  // namespace
+
+QVariant outfit::utils::csv::ReadWatermark(const QString& file_name) {
+    const auto saved = LoadWatermark(file_name);
+    return saved ? saved->value : QVariant();
+}
+
+std::optional<outfit::utils::csv::IncrementalStats> outfit::utils::csv::ExportIncremental(
+    const IncrementalExport& spec) {
+    const auto saved = LoadWatermark(spec.file_name);
+    // A watermark of another column says nothing about this one.
+    if (!saved || (!saved->column.isEmpty() && saved->column != spec.watermark_column)) {
+        return std::nullopt;
+    }
+    IncrementalStats stats;
+    QSqlQuery query(QSqlDatabase::database(spec.connection_name));
+    const Timer exec_timer;
+    if (!ExecuteDelta(spec, saved->value, query)) {
+        return std::nullopt;
+    }
+    stats.export_stats.exec = exec_timer.GetTimes().wall_time;
+    const int column = query.record().indexOf(spec.watermark_column);
+    if (column < 0) {
+        return std::nullopt;
+    }
+
+    QueryCursor rows(query);
+    WatermarkCursor cursor(rows, column, *saved);
+    QString header = spec.header;
+    if (header.isEmpty()) {
+        const QSqlRecord record = query.record();
+        QStringList names;
+        for (int i = 0; i < record.count(); ++i) {
+            names << record.fieldName(i);
+        }
+        header = names.join(QLatin1Char(','));
+    }
+    stats.watermark = saved->value;
+    // Reads the first batch, so it counts as fetch time.
+    const Timer first_fetch;
+    const bool empty = cursor.Empty();
+    stats.export_stats.fetch += first_fetch.GetTimes().wall_time;
+    if (empty) {
+        return cursor.Error().isEmpty() ? std::optional(stats) : std::nullopt;
+    }
+    const auto track = [&stats](const ExportProgress& progress) {
+        stats.rows = progress.rows;
+        stats.bytes = progress.bytes;
+        return true;
+    };
+
+    const auto save_watermark = [&] {
+        return SaveWatermark(
+            spec.file_name, spec.watermark_column, cursor.Last(), cursor.LastRows());
+    };
+
+    if (spec.mode == IncrementalMode::kDeltaFile) {
+        stats.written_file = DeltaFileName(spec.file_name, QDateTime::currentDateTimeUtc());
+        QSaveFile file(stats.written_file);
+        // WriteRows also fails on a fetch error, in which case the QSaveFile discards the
+        // truncated delta instead of publishing it.
+        if (!file.open(QFile::WriteOnly) ||
+            !WriteRows(
+                header, true, cursor, file, CompressionForFile(stats.written_file), track,
+                stats.export_stats) ||
+            !file.commit()) {
+            return std::nullopt;
+        }
+        if (!save_watermark()) {
+            QFile::remove(stats.written_file);
+            return std::nullopt;
+        }
+    } else {
+        stats.written_file = spec.file_name;
+        QFile file(spec.file_name);
+        const qint64 original_size = file.size();
+        if (!file.open(QFile::WriteOnly | QFile::Append)) {
+            return std::nullopt;
+        }
+        // Only a new file gets the header; later runs append rows under the existing one.
+        if (!WriteRows(
+                header, original_size == 0, cursor, file, CompressionForFile(spec.file_name),
+                track, stats.export_stats) ||
+            !file.flush() || !save_watermark()) {
+            // Cut off whatever this run appended: a partial line, or for .gz and .zst a
+            // truncated member, would corrupt everything the next run appends after it.
+            file.resize(original_size);
+            return std::nullopt;
+        }
+    }
+    stats.watermark = cursor.Last();
+    return stats;
+}
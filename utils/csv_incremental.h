@@ -0,0 +1,65 @@
+#ifndef CREATIVE_CSV_INCREMENTAL_H
+#define CREATIVE_CSV_INCREMENTAL_H
+
+#include "csv_stats.h"
+
+#include <QString>
+#include <QVariant>
+#include <QVariantList>
+
+#include <optional>
+
+namespace outfit::utils::csv {
+enum class IncrementalMode {
+    // New rows are appended to file_name; the header is written only when the file is new.
+    kAppend,
+    // New rows go to a sibling file stamped with the export time, e.g.
+    // items.20261018T120000123Z.csv.gz next to items.csv.gz. Nothing is written when no rows
+    // are new.
+    kDeltaFile,
+};
+
+struct IncrementalExport {
+    // Used from the calling thread.
+    QString connection_name;
+    // Source query; it is wrapped as a derived table and filtered on the watermark column.
+    QString sql;
+    QVariantList bound_values;
+    // Column of the query's result whose value only grows for new rows, such as a rowid, a
+    // sequence or an updated_at that is never set in the past. Rows where it is NULL are
+    // never exported.
+    QString watermark_column;
+    // Column names when empty.
+    QString header;
+    // Export target; .gz and .zst outputs get one compressed member per run, which readers
+    // decompress as a single stream. The watermark is kept next to it in
+    // <file_name>.watermark.json.
+    QString file_name;
+    IncrementalMode mode = IncrementalMode::kAppend;
+};
+
+struct IncrementalStats {
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    // Watermark after this run; null until the first row was exported.
+    QVariant watermark;
+    // File the rows went to; empty when a delta run found nothing new.
+    QString written_file;
+    // Stage times of the run; exec covers the wrapped watermark query.
+    ExportStats export_stats;
+};
+
+// Exports the rows whose watermark column is greater than or equal to the one saved by the
+// previous run, in watermark order, then saves the new watermark. Rows equal to the saved
+// watermark that the previous run exported are recognised by their contents and skipped, so
+// the column does not need to be unique. The watermark is saved only after the rows were
+// written, and a run that fails removes what it wrote, so it is repeated in full by the
+// next one: rows may be exported twice after a crash but are never skipped. Returns nothing
+// on any error.
+std::optional<IncrementalStats> ExportIncremental(const IncrementalExport& spec);
+
+// Watermark saved for the export target, or null if there is none yet.
+QVariant ReadWatermark(const QString& file_name);
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_INCREMENTAL_H
@@ -0,0 +1,199 @@
+#include "csv_load.h"
+
+#include "csv_escape.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLatin1Char>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringList>
+#include <QStringLiteral>
+#include <QVariant>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr int kMaxBoundValues = 999;
+
+// Splits mapped CSV data into records. Fields are decoded into a reused row buffer.
+class RecordReader {
+   public:
+    RecordReader(const char* data, qsizetype size, bool empty_as_null)
+        : current_{data}, end_{data + size}, empty_as_null_{empty_as_null} {
+    }
+
+    // Returns false at the end of data or on malformed input, see HasError.
+    bool Next(QVariantList& row) {
+        row.clear();
+        if (current_ == end_ || has_error_) {
+            return false;
+        }
+        while (true) {
+            row.push_back(ReadField());
+            if (current_ == end_) {
+                return !has_error_;
+            }
+            const char separator = *current_++;
+            if (separator == ',') {
+                continue;
+            }
+            if (separator == '\r' && current_ != end_ && *current_ == '\n') {
+                ++current_;
+            }
+            return !has_error_;
+        }
+    }
+
+    [[nodiscard]] bool HasError() const {
+        return has_error_;
+    }
+
+   private:
+    QVariant ReadField() {
+        if (current_ == end_ || *current_ != '"') {
+            const qsizetype size = outfit::utils::csv::FindSpecial(current_, end_ - current_);
+            const char* begin = current_;
+            current_ += size;
+            if (current_ != end_ && *current_ == '"') {
+                has_error_ = true;
+            }
+            if (size == 0 && empty_as_null_) {
+                return {};
+            }
+            return QString::fromUtf8(begin, size);
+        }
+        ++current_;
+        unquoted_.clear();
+        while (true) {
+            const auto* quote =
+                static_cast<const char*>(std::memchr(current_, '"', end_ - current_));
+            if (quote == nullptr) {
+                has_error_ = true;
+                current_ = end_;
+                return {};
+            }
+            unquoted_.append(current_, quote - current_);
+            current_ = quote + 1;
+            if (current_ == end_ || *current_ != '"') {
+                break;
+            }
+            unquoted_.append('"');
+            ++current_;
+        }
+        if (current_ != end_ && *current_ != ',' && *current_ != '\n' && *current_ != '\r') {
+            has_error_ = true;
+        }
+        return QString::fromUtf8(unquoted_);
+    }
+
+    const char* current_;
+    const char* end_;
+    QByteArray unquoted_;
+    bool empty_as_null_;
+    bool has_error_ = false;
+};
+
+QString InsertStatement(
+    const QSqlDriver& driver, const QString& table, const QStringList& columns, int rows) {
+    QStringList names;
+    for (const QString& column : columns) {
+        names << driver.escapeIdentifier(column.trimmed(), QSqlDriver::FieldName);
+    }
+    const QString row_placeholders =
+        QStringList(columns.size(), QStringLiteral("?")).join(QLatin1Char(','));
+    const QString placeholders = QLatin1Char('(') + row_placeholders + QLatin1Char(')');
+    return QStringLiteral("INSERT INTO %1 (%2) VALUES %3")
+        .arg(
+            driver.escapeIdentifier(table, QSqlDriver::TableName), names.join(QLatin1Char(',')),
+            QStringList(rows, placeholders).join(QLatin1Char(',')));
+}
+
+bool InsertBatch(QSqlQuery& insert, const std::vector<QVariantList>& rows, qsizetype count) {
+    int index = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        for (const QVariant& value : rows[i]) {
+            insert.bindValue(index++, value);
+        }
+    }
+    return insert.exec();
+}
+}  // namespace
+
+std::optional<outfit::utils::csv::LoadStats> outfit::utils::csv::LoadIntoTable(
+    const QString& file_name, const QString& connection_name, const QString& table,
+    const LoadOptions& options) {
+    QElapsedTimer timer;
+    timer.start();
+    QFile csv_file(file_name);
+    if (!csv_file.open(QFile::ReadOnly)) {
+        return std::nullopt;
+    }
+    LoadStats stats;
+    stats.bytes = csv_file.size();
+    if (stats.bytes == 0) {
+        return std::nullopt;
+    }
+    const uchar* mapped = csv_file.map(0, stats.bytes);
+    if (mapped == nullptr) {
+        return std::nullopt;
+    }
+    RecordReader reader(reinterpret_cast<const char*>(mapped), stats.bytes,  // NOLINT
+                        options.empty_as_null);
+
+    QVariantList header;
+    if (!reader.Next(header)) {
+        return std::nullopt;
+    }
+    QStringList columns = options.columns;
+    if (columns.isEmpty()) {
+        for (const QVariant& name : std::as_const(header)) {
+            columns << name.toString();
+        }
+    }
+    const auto column_count = columns.size();
+    const int rows_per_batch = options.rows_per_batch > 0
+                                   ? options.rows_per_batch
+                                   : std::max(1, static_cast<int>(kMaxBoundValues / column_count));
+
+    QSqlDatabase db = QSqlDatabase::database(connection_name);
+    if (!db.transaction()) {
+        return std::nullopt;
+    }
+    bool ok = true;
+    {
+        QSqlQuery insert(db);
+        ok = insert.prepare(InsertStatement(*db.driver(), table, columns, rows_per_batch));
+        std::vector<QVariantList> rows(rows_per_batch);
+        qsizetype pending = 0;
+        while (ok && reader.Next(rows[pending])) {
+            if (rows[pending].size() != column_count) {
+                ok = false;
+            } else if (++pending == rows_per_batch) {
+                ok = InsertBatch(insert, rows, pending);
+                stats.rows += pending;
+                pending = 0;
+            }
+        }
+        ok = ok && !reader.HasError();
+        if (ok && pending > 0) {
+            QSqlQuery tail(db);
+            ok = tail.prepare(InsertStatement(*db.driver(), table, columns, pending)) &&
+                 InsertBatch(tail, rows, pending);
+            stats.rows += pending;
+        }
+    }
+    if (!ok || !db.commit()) {
+        db.rollback();
+        return std::nullopt;
+    }
+    stats.elapsed_ms = timer.elapsed();
+    return stats;
+}
@@ -0,0 +1,39 @@
+#ifndef CREATIVE_CSV_LOAD_H
+#define CREATIVE_CSV_LOAD_H
+
+#include <QString>
+#include <QStringList>
+
+#include <optional>
+
+namespace outfit::utils::csv {
+struct LoadOptions {
+    // Target columns; taken from the file's header line when empty.
+    QStringList columns;
+    // Rows bound into one multi-row INSERT; derived from a 999 parameter limit when not
+    // positive.
+    int rows_per_batch = 0;
+    // Unquoted empty fields are inserted as NULL. SaveQuery writes NULL and empty strings the
+    // same way, so this is how numeric NULLs come back.
+    bool empty_as_null = false;
+};
+
+struct LoadStats {
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    qint64 elapsed_ms = 0;
+
+    [[nodiscard]] double RowsPerSecond() const {
+        return elapsed_ms > 0 ? rows * 1000. / elapsed_ms : 0.;
+    }
+};
+
+// Maps the file, splits it into RFC 4180 records and inserts them into the table in batched
+// prepared statements inside a single transaction. The first line is always a header.
+// Returns nothing and leaves the table untouched on any error.
+std::optional<LoadStats> LoadIntoTable(
+    const QString& file_name, const QString& connection_name, const QString& table,
+    const LoadOptions& options = {});
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_LOAD_H
@@ -0,0 +1,118 @@
+#include "csv_load.h"
+#include "csv_writer.h"
+
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QString>
+#include <QStringLiteral>
+#include <QTemporaryDir>
+#include <QVariant>
+#include <QVariantList>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <limits>
+#include <vector>
+
+namespace {
+const QString kConnection = QStringLiteral("csv_load_test");
+
+QSqlDatabase OpenDatabase() {
+    QSqlDatabase::removeDatabase(kConnection);
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), kConnection);
+    db.setDatabaseName(QStringLiteral(":memory:"));
+    REQUIRE(db.open());
+    for (const QString& table : {QStringLiteral("items"), QStringLiteral("loaded")}) {
+        REQUIRE(QSqlQuery(db).exec(
+            QStringLiteral("CREATE TABLE %1 (id INTEGER, name TEXT, price REAL)").arg(table)));
+    }
+    return db;
+}
+
+// Every row has a non-empty name: the CSV cannot tell an empty string from NULL.
+void FillItems(QSqlDatabase& db, int rows) {
+    const std::vector<QString> names = {
+        QStringLiteral("plain"),
+        QStringLiteral("comma, inside"),
+        QStringLiteral("\"quoted\" and \"\"doubled\"\""),
+        QStringLiteral("line\nbreak"),
+        QStringLiteral("crlf\r\nline"),
+        QStringLiteral(" padded "),
+        QStringLiteral("\u00fcnic\u00f6de \u2603"),
+        QStringLiteral(","),
+        QStringLiteral("\""),
+    };
+    const std::vector<QVariant> prices = {
+        0.1, -2.5e10, 3.141592653589793, 42., QVariant(),
+    };
+    QSqlQuery insert(db);
+    REQUIRE(insert.prepare(QStringLiteral("INSERT INTO items VALUES (?, ?, ?)")));
+    for (int row = 0; row < rows; ++row) {
+        insert.addBindValue(
+            row % 7 == 3 ? QVariant()
+                         : QVariant::fromValue(std::numeric_limits<qint64>::max() - row));
+        insert.addBindValue(names[row % names.size()]);
+        insert.addBindValue(prices[row % prices.size()]);
+        REQUIRE(insert.exec());
+    }
+}
+
+std::vector<QVariantList> ReadTable(QSqlDatabase& db, const QString& table) {
+    QSqlQuery query(db);
+    REQUIRE(query.exec(QStringLiteral("SELECT id, name, price FROM %1 ORDER BY rowid").arg(table)));
+    std::vector<QVariantList> rows;
+    while (query.next()) {
+        rows.push_back({query.value(0), query.value(1), query.value(2)});
+    }
+    return rows;
+}
+
+QString Export(QSqlDatabase& db, const QTemporaryDir& dir) {
+    const QString file_name = dir.filePath(QStringLiteral("items.csv"));
+    QFile file(file_name);
+    REQUIRE(file.open(QFile::WriteOnly));
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    REQUIRE(query.exec(QStringLiteral("SELECT id, name, price FROM items ORDER BY rowid")));
+    REQUIRE(outfit::utils::csv::ExportQuery(QStringLiteral("id,name,price"), query, file));
+    return file_name;
+}
+}  // namespace
+
+TEST_CASE("LoadIntoTable reads back what ExportQuery wrote") {
+    QSqlDatabase db = OpenDatabase();
+    const QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    // Several full batches and a partial one.
+    constexpr int kRows = 1000;
+    FillItems(db, kRows);
+    const QString file_name = Export(db, dir);
+
+    for (const int rows_per_batch : {0, 1, 7}) {
+        CAPTURE(rows_per_batch);
+        REQUIRE(QSqlQuery(db).exec(QStringLiteral("DELETE FROM loaded")));
+        const auto stats = outfit::utils::csv::LoadIntoTable(
+            file_name, kConnection, QStringLiteral("loaded"),
+            {.rows_per_batch = rows_per_batch, .empty_as_null = true});
+        REQUIRE(stats);
+        CHECK(stats->rows == kRows);
+        CHECK(ReadTable(db, QStringLiteral("loaded")) == ReadTable(db, QStringLiteral("items")));
+    }
+}
+
+TEST_CASE("LoadIntoTable leaves the table untouched on a malformed file") {
+    QSqlDatabase db = OpenDatabase();
+    const QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString file_name = dir.filePath(QStringLiteral("broken.csv"));
+    QFile file(file_name);
+    REQUIRE(file.open(QFile::WriteOnly));
+    // The second record is short a column, the last quote is never closed.
+    file.write("id,name,price\n1,a,1.5\n2,b\n3,\"c,3\n");
+    file.close();
+
+    CHECK_FALSE(outfit::utils::csv::LoadIntoTable(
+        file_name, kConnection, QStringLiteral("loaded"), {.rows_per_batch = 1}));
+    CHECK(ReadTable(db, QStringLiteral("loaded")).empty());
+}
@@ -0,0 +1,209 @@
+#include "csv_partitioned.h"
+
+#include "csv_cursor.h"
+#include "csv_stats.h"
+#include "csv_writer.h"
+#include "tools/util/util.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QIODevice>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QLatin1Char>
+#include <QMetaType>
+#include <QStringList>
+#include <QStringLiteral>
+#include <QThread>
+#include <QVariant>
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace {
+using outfit::utils::csv::CsvWriter;
+using outfit::utils::csv::ExportCursor;
+using outfit::utils::csv::ExportStats;
+using outfit::utils::csv::PartitionedExport;
+using outfit::utils::csv::QueryCursor;
+
+struct KeyRange {
+    qint64 from;
+    qint64 to;
+};
+
+QString SelectStatement(const QSqlDriver& driver, const PartitionedExport& spec) {
+    QStringList columns;
+    for (const QString& column : spec.columns) {
+        columns << driver.escapeIdentifier(column, QSqlDriver::FieldName);
+    }
+    return QStringLiteral("SELECT %1 FROM %2 WHERE %3 BETWEEN ? AND ? ORDER BY %3")
+        .arg(
+            columns.isEmpty() ? QStringLiteral("*") : columns.join(QLatin1Char(',')),
+            driver.escapeIdentifier(spec.table, QSqlDriver::TableName),
+            driver.escapeIdentifier(spec.key_column, QSqlDriver::FieldName));
+}
+
+bool IsIntegral(QMetaType type) {
+    switch (type.id()) {
+        case QMetaType::Short:
+        case QMetaType::UShort:
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::Long:
+        case QMetaType::ULong:
+        case QMetaType::LongLong:
+        case QMetaType::ULongLong:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Leaves range empty for an empty table. Fails for keys that are not integers: truncating a
+// real or text bound would silently leave rows out of every partition.
+bool ReadKeyRange(const PartitionedExport& spec, std::optional<KeyRange>& range) {
+    const QSqlDatabase db = QSqlDatabase::database(spec.connection_name);
+    const QSqlDriver& driver = *db.driver();
+    QSqlQuery query(db);
+    const QString key = driver.escapeIdentifier(spec.key_column, QSqlDriver::FieldName);
+    if (!query.exec(QStringLiteral("SELECT MIN(%1), MAX(%1) FROM %2")
+                        .arg(key, driver.escapeIdentifier(spec.table, QSqlDriver::TableName))) ||
+        !query.next()) {
+        return false;
+    }
+    if (query.isNull(0)) {
+        return true;
+    }
+    const QSqlRecord record = query.record();
+    if (!IsIntegral(record.field(0).metaType()) || !IsIntegral(record.field(1).metaType())) {
+        return false;
+    }
+    bool from_ok = false;
+    bool to_ok = false;
+    range = KeyRange{query.value(0).toLongLong(&from_ok), query.value(1).toLongLong(&to_ok)};
+    return from_ok && to_ok;
+}
+
+std::vector<KeyRange> SplitKeyRange(KeyRange range, int partitions) {
+    // Unsigned arithmetic keeps the full qint64 span representable.
+    const auto width = static_cast<quint64>(range.to) - static_cast<quint64>(range.from);
+    const quint64 step = width / static_cast<quint64>(partitions) + 1;
+    std::vector<KeyRange> ranges;
+    for (quint64 offset = 0; offset <= width; offset += step) {
+        const quint64 last = std::min(width, offset + step - 1);
+        ranges.push_back(
+            {static_cast<qint64>(static_cast<quint64>(range.from) + offset),
+             static_cast<qint64>(static_cast<quint64>(range.from) + last)});
+        if (last == width) {
+            break;
+        }
+    }
+    return ranges;
+}
+
+// The range's rows as CSV without a header, with the times spent executing, fetching and
+// formatting them; the buffer writes count as formatting.
+std::optional<QByteArray> ExportRange(
+    const PartitionedExport& spec, KeyRange range, int index, ExportStats& stats) {
+    const QString connection = QStringLiteral("outfit_csv_partition_%1_%2")
+                                   .arg(reinterpret_cast<quintptr>(&spec), 0, 16)  // NOLINT
+                                   .arg(index);
+    std::optional<QByteArray> result;
+    {
+        QSqlDatabase db = QSqlDatabase::cloneDatabase(spec.connection_name, connection);
+        if (db.open()) {
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            query.prepare(SelectStatement(*db.driver(), spec));
+            query.addBindValue(range.from);
+            query.addBindValue(range.to);
+            const Timer exec_timer;
+            const bool executed = query.exec();
+            stats.exec += exec_timer.GetTimes().wall_time;
+            if (executed) {
+                QByteArray bytes;
+                QBuffer buffer(&bytes);
+                buffer.open(QIODevice::WriteOnly);
+                QueryCursor cursor(query);
+                // Also fails on a fetch error, which would drop the rest of the range.
+                const bool written = ExportCursor(QString(), false, cursor, buffer, {}, stats);
+                buffer.close();
+                // Copying into the buffer is part of formatting; the device writes are timed
+                // after concatenation.
+                stats.format += stats.write;
+                stats.write = {};
+                if (written) {
+                    result = std::move(bytes);
+                }
+            }
+        }
+    }
+    QSqlDatabase::removeDatabase(connection);
+    return result;
+}
+}  // namespace
+
+bool outfit::utils::csv::ExportPartitioned(
+    const QString& header, const PartitionedExport& spec, QIODevice& device) {
+    ExportStats stats;
+    return ExportPartitioned(header, spec, device, stats);
+}
+
+bool outfit::utils::csv::ExportPartitioned(
+    const QString& header, const PartitionedExport& spec, QIODevice& device,
+    ExportStats& stats) {
+    std::optional<KeyRange> key_range;
+    if (!ReadKeyRange(spec, key_range)) {
+        return false;
+    }
+    {
+        CsvWriter writer(&device, header.size() * 3 + 1);
+        writer.WriteLine(header);
+        const bool flushed = writer.Flush();
+        stats.write += writer.WriteTime();
+        stats.bytes += writer.BytesWritten();
+        if (!flushed) {
+            return false;
+        }
+    }
+    if (!key_range) {
+        return true;
+    }
+    const int partitions = spec.partitions > 0 ? spec.partitions : QThread::idealThreadCount();
+    const auto ranges = SplitKeyRange(*key_range, std::max(partitions, 1));
+
+    std::vector<ExportStats> range_stats(ranges.size());
+    std::vector<std::future<std::optional<QByteArray>>> parts;
+    parts.reserve(ranges.size());
+    for (int i = 0; i < static_cast<int>(ranges.size()); ++i) {
+        parts.push_back(std::async(
+            std::launch::async, ExportRange, std::cref(spec), ranges[i], i,
+            std::ref(range_stats[i])));
+    }
+    // Buffers are written and released in key order as soon as each one is ready.
+    bool ok = true;
+    for (auto& part : parts) {
+        const auto bytes = part.get();
+        const Timer write_timer;
+        ok = ok && bytes && device.write(*bytes) == bytes->size();
+        stats.write += write_timer.GetTimes().wall_time;
+    }
+    for (const ExportStats& range : range_stats) {
+        stats.exec += range.exec;
+        stats.fetch += range.fetch;
+        stats.format += range.format;
+        stats.rows += range.rows;
+        stats.bytes += range.bytes;
+        stats.max_row_width = std::max(stats.max_row_width, range.max_row_width);
+    }
+    return ok;
+}
@@ -0,0 +1,36 @@
+#ifndef CREATIVE_CSV_PARTITIONED_H
+#define CREATIVE_CSV_PARTITIONED_H
+
+#include "csv_stats.h"
+
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+
+namespace outfit::utils::csv {
+struct PartitionedExport {
+    // Connection the partitions are cloned from; the key range is read through it directly,
+    // so call from the thread that owns it.
+    QString connection_name;
+    QString table;
+    // Integer column the key range is split on; other types make the export fail. Rows come
+    // out ordered by it.
+    QString key_column;
+    // Selected columns; all columns when empty.
+    QStringList columns;
+    // Number of key ranges exported concurrently; QThread::idealThreadCount() when not positive.
+    int partitions = 0;
+};
+
+// Splits the key range into partitions, formats each on its own thread and connection into
+// an in-memory buffer, and writes the buffers to the device in key order.
+bool ExportPartitioned(const QString& header, const PartitionedExport& spec, QIODevice& device);
+// Also adds the stats: exec and fetch times are summed over the ranges, which run
+// concurrently, so they can exceed the wall time; format covers building the buffers, and
+// write the header and the buffers going to the device in key order.
+bool ExportPartitioned(
+    const QString& header, const PartitionedExport& spec, QIODevice& device,
+    ExportStats& stats);
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_PARTITIONED_H
@@ -0,0 +1,38 @@
+#include "csv_stats.h"
+
+#include <QByteArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+#include <QStringLiteral>
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+namespace {
+double Milliseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+}  // namespace
+
+QByteArray outfit::utils::csv::StatsToJson(const ExportStats& stats) {
+    QJsonObject object;
+    object[QStringLiteral("exec_ms")] = Milliseconds(stats.exec);
+    object[QStringLiteral("fetch_ms")] = Milliseconds(stats.fetch);
+    object[QStringLiteral("format_ms")] = Milliseconds(stats.format);
+    object[QStringLiteral("write_ms")] = Milliseconds(stats.write);
+    object[QStringLiteral("rows")] = stats.rows;
+    object[QStringLiteral("bytes")] = stats.bytes;
+    object[QStringLiteral("max_row_width")] = stats.max_row_width;
+    return QJsonDocument(object).toJson(QJsonDocument::Compact);
+}
+
+void outfit::utils::csv::LogStats(const QString& label, const ExportStats& stats) {
+    spdlog::info(
+        "csv export {}: {} rows, {} bytes, max row {} bytes; exec {:.1f} ms, fetch {:.1f} ms, "
+        "format {:.1f} ms, write {:.1f} ms",
+        label.toStdString(), stats.rows, stats.bytes, stats.max_row_width,
+        Milliseconds(stats.exec), Milliseconds(stats.fetch), Milliseconds(stats.format),
+        Milliseconds(stats.write));
+}
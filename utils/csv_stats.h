@@ -0,0 +1,39 @@
+#ifndef CREATIVE_CSV_STATS_H
+#define CREATIVE_CSV_STATS_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <chrono>
+#include <functional>
+
+namespace outfit::utils::csv {
+// Where an export spent its time. Stages are timed per batch or per written block, never per
+// row, so collecting them does not slow the export down.
+struct ExportStats {
+    // Executing the query, as measured by the caller that ran it.
+    std::chrono::nanoseconds exec{};
+    // Waiting for rows from the cursor.
+    std::chrono::nanoseconds fetch{};
+    // Formatting rows into the buffer, excluding write.
+    std::chrono::nanoseconds format{};
+    // Handing full buffers to the device, including compression done inline.
+    std::chrono::nanoseconds write{};
+    qint64 rows = 0;
+    qint64 bytes = 0;
+    // Longest row in bytes, including the line break.
+    qint64 max_row_width = 0;
+};
+
+using StatsCallback = std::function<void(const ExportStats&)>;
+
+// One compact JSON object; durations are in milliseconds:
+// {"exec_ms":1.5,"fetch_ms":..,"format_ms":..,"write_ms":..,"rows":..,"bytes":..,
+//  "max_row_width":..}
+QByteArray StatsToJson(const ExportStats& stats);
+
+// Logs the stats as one info line through spdlog's default logger.
+void LogStats(const QString& label, const ExportStats& stats);
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_STATS_H
@@ -0,0 +1,417 @@
+#include "csv_writer.h"
+
+#include "csv_escape.h"
+#include "tools/util/util.h"
+
+#include <QByteArray>
+#include <QDate>
+#include <QDateTime>
+#include <QIODevice>
+#include <QLatin1Char>
+#include <QMetaType>
+#include <QSqlField>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringView>
+#include <QTime>
+#include <QVariant>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+outfit::utils::csv::CsvWriter::CsvWriter(QIODevice* device, qsizetype block_size)
+    : device_{device}, buffer_(block_size, Qt::Uninitialized) {
+}
+
+outfit::utils::csv::CsvWriter::~CsvWriter() {
+    Flush();
+}
+
+void outfit::utils::csv::CsvWriter::WriteLine(QStringView line) {
+    Append(line);
+    Append('\n');
+}
+
+void outfit::utils::csv::CsvWriter::WriteField(QStringView field) {
+    const FieldClass field_class = ClassifyField(field);
+    if (!field_class.needs_quoting) {
+        Append(field);
+        return;
+    }
+    Append('"');
+    if (field_class.quotes == 0) {
+        Append(field);
+        Append('"');
+        return;
+    }
+    qsizetype begin = 0;
+    for (qsizetype quote = field.indexOf(QLatin1Char('"')); quote != -1;
+         quote = field.indexOf(QLatin1Char('"'), begin)) {
+        Append(field.sliced(begin, quote + 1 - begin));
+        Append('"');
+        begin = quote + 1;
+    }
+    Append(field.sliced(begin));
+    Append('"');
+}
+
+void outfit::utils::csv::CsvWriter::SetColumns(const QSqlRecord& record) {
+    columns_.clear();
+    for (int i = 0; i < record.count(); ++i) {
+        const int type_id = record.field(i).metaType().id();
+        columns_.push_back({type_id, FormatFor(type_id)});
+    }
+}
+
+void outfit::utils::csv::CsvWriter::WriteRow(const QSqlQuery& query) {
+    const qint64 start = bytes_written_ + used_;
+    for (int i = 0, count = static_cast<int>(columns_.size()); i < count; ++i) {
+        if (i > 0) {
+            Append(',');
+        }
+        WriteValue(query.value(i), i);
+    }
+    Append('\n');
+    max_row_width_ = std::max(max_row_width_, bytes_written_ + used_ - start);
+}
+
+void outfit::utils::csv::CsvWriter::WriteBatch(const RowBatch& batch) {
+    const auto columns = static_cast<int>(columns_.size());
+    for (qsizetype row = 0; row < batch.Rows(); ++row) {
+        const qint64 start = bytes_written_ + used_;
+        for (int i = 0; i < columns; ++i) {
+            if (i > 0) {
+                Append(',');
+            }
+            WriteValue(batch.Value(row, i), i);
+        }
+        Append('\n');
+        max_row_width_ = std::max(max_row_width_, bytes_written_ + used_ - start);
+    }
+}
+
+void outfit::utils::csv::CsvWriter::WriteValue(const QVariant& value, int column) {
+    // Drivers may hand out values of another type than the field reports (SQLite declares
+    // INTEGER columns as int but returns qlonglong), so the plan follows the actual values.
+    Column& plan = columns_[column];
+    if (value.typeId() != plan.type_id) {
+        plan = {value.typeId(), FormatFor(value.typeId())};
+    }
+    // Null values keep toString() semantics.
+    if (!value.isNull()) {
+        const void* data = value.constData();
+        switch (plan.format) {
+            case Format::kText:
+                WriteField(*static_cast<const QString*>(data));
+                return;
+            case Format::kInt:
+                AppendNumber(*static_cast<const int*>(data));
+                return;
+            case Format::kUInt:
+                AppendNumber(*static_cast<const uint*>(data));
+                return;
+            case Format::kLongLong:
+                AppendNumber(*static_cast<const qlonglong*>(data));
+                return;
+            case Format::kULongLong:
+                AppendNumber(*static_cast<const qulonglong*>(data));
+                return;
+            case Format::kDouble:
+                if (AppendDouble(*static_cast<const double*>(data))) {
+                    return;
+                }
+                break;
+            case Format::kBool: {
+                const bool flag = *static_cast<const bool*>(data);
+                Append(flag ? QStringView(u"true") : QStringView(u"false"));
+                return;
+            }
+            case Format::kDate:
+                if (AppendDate(*static_cast<const QDate*>(data))) {
+                    return;
+                }
+                break;
+            case Format::kTime:
+                if (AppendTime(*static_cast<const QTime*>(data))) {
+                    return;
+                }
+                break;
+            case Format::kDateTime:
+                if (AppendDateTime(value)) {
+                    return;
+                }
+                break;
+            case Format::kGeneric:
+                break;
+        }
+    }
+    WriteField(value.toString());
+}
+
+bool outfit::utils::csv::CsvWriter::Flush() {
+    if (used_ > 0) {
+        const Timer timer;
+        const qint64 written = device_->write(buffer_.constData(), used_);
+        write_time_ += timer.GetTimes().wall_time;
+        if (written != used_) {
+            has_error_ = true;
+        } else {
+            bytes_written_ += used_;
+        }
+        used_ = 0;
+    }
+    return !has_error_;
+}
+
+char* outfit::utils::csv::CsvWriter::Reserve(qsizetype bytes) {
+    if (used_ + bytes > buffer_.size()) {
+        Flush();
+        if (bytes > buffer_.size()) {
+            buffer_.resize(bytes);
+        }
+    }
+    return buffer_.data() + used_;
+}
+
+void outfit::utils::csv::CsvWriter::Append(QStringView text) {
+    char* out = Reserve(encoder_.requiredSpace(text.size()));
+    used_ = encoder_.appendToBuffer(out, text) - buffer_.constData();
+}
+
+void outfit::utils::csv::CsvWriter::Append(char c) {
+    *Reserve(1) = c;
+    ++used_;
+}
+
+outfit::utils::csv::CsvWriter::Format outfit::utils::csv::CsvWriter::FormatFor(int type_id) {
+    switch (type_id) {
+        case QMetaType::QString:
+            return Format::kText;
+        case QMetaType::Int:
+            return Format::kInt;
+        case QMetaType::UInt:
+            return Format::kUInt;
+        case QMetaType::LongLong:
+            return Format::kLongLong;
+        case QMetaType::ULongLong:
+            return Format::kULongLong;
+        case QMetaType::Double:
+            return Format::kDouble;
+        case QMetaType::Bool:
+            return Format::kBool;
+        case QMetaType::QDate:
+            return Format::kDate;
+        case QMetaType::QTime:
+            return Format::kTime;
+        case QMetaType::QDateTime:
+            return Format::kDateTime;
+        default:
+            return Format::kGeneric;
+    }
+}
+
+template <class T>
+void outfit::utils::csv::CsvWriter::AppendNumber(T value) {
+    constexpr qsizetype kMaxDigits = std::numeric_limits<T>::digits10 + 2;
+    char* out = Reserve(kMaxDigits);
+    used_ = std::to_chars(out, out + kMaxDigits, value).ptr - buffer_.constData();
+}
+
+bool outfit::utils::csv::CsvWriter::AppendDouble(double value) {
+    // QString::number(value, 'g', QLocale::FloatingPointShortest): the shortest round-trip
+    // digits, written in decimal unless that needs more than kExponentBias zeros of padding
+    // or leading zeros (the cost of "e", the sign and two exponent digits; the separator is
+    // not counted). Qt spells nan and inf differently, and -0 is left to Qt as well.
+    if (!std::isfinite(value) || (value == 0. && std::signbit(value))) {
+        return false;
+    }
+    if (value == 0.) {
+        Append('0');
+        return true;
+    }
+    constexpr int kExponentBias = 4;
+    // "-d.dddddddddddddddde-308"
+    std::array<char, 32> scientific{};
+    const char* const begin = scientific.data();
+    const char* const end =
+        std::to_chars(
+            scientific.data(), scientific.data() + scientific.size(), value,
+            std::chars_format::scientific)
+            .ptr;
+    const char* const e = std::find(begin, end, 'e');
+    int exponent = 0;
+    std::from_chars(e[1] == '+' ? e + 2 : e + 1, end, exponent);
+    std::array<char, std::numeric_limits<double>::max_digits10> digits{};
+    int digit_count = 0;
+    for (const char* c = begin; c != e; ++c) {
+        if (*c >= '0' && *c <= '9') {
+            digits[digit_count++] = *c;
+        }
+    }
+    // Digits before the decimal point in decimal form.
+    const int point = exponent + 1;
+    const bool decimal =
+        point <= 0 ? 1 - point <= kExponentBias : point <= digit_count + kExponentBias;
+
+    char* out = Reserve(static_cast<qsizetype>(scientific.size()));
+    if (!decimal) {
+        out = std::copy(begin, end, out);
+    } else {
+        if (value < 0.) {
+            *out++ = '-';
+        }
+        const char* const digits_begin = digits.data();
+        const char* const digits_end = digits_begin + digit_count;
+        if (point <= 0) {
+            *out++ = '0';
+            *out++ = '.';
+            out = std::fill_n(out, -point, '0');
+            out = std::copy(digits_begin, digits_end, out);
+        } else if (point >= digit_count) {
+            out = std::copy(digits_begin, digits_end, out);
+            out = std::fill_n(out, point - digit_count, '0');
+        } else {
+            out = std::copy(digits_begin, digits_begin + point, out);
+            *out++ = '.';
+            out = std::copy(digits_begin + point, digits_end, out);
+        }
+    }
+    used_ = out - buffer_.constData();
+    return true;
+}
+
+namespace {
+char* WriteDigits(char* out, int value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+}  // namespace
+
+bool outfit::utils::csv::CsvWriter::AppendDate(QDate date) {
+    // Qt::ISODate, yyyy-MM-dd; years outside 1..9999 are formatted differently.
+    int year = 0;
+    int month = 0;
+    int day = 0;
+    date.getDate(&year, &month, &day);
+    if (!date.isValid() || year < 1 || year > 9999) {
+        return false;
+    }
+    char* out = Reserve(10);
+    out = WriteDigits(out, year, 4);
+    *out++ = '-';
+    out = WriteDigits(out, month, 2);
+    *out++ = '-';
+    out = WriteDigits(out, day, 2);
+    used_ = out - buffer_.constData();
+    return true;
+}
+
+bool outfit::utils::csv::CsvWriter::AppendTime(QTime time) {
+    // Qt::ISODateWithMs, HH:mm:ss.zzz.
+    if (!time.isValid()) {
+        return false;
+    }
+    char* out = Reserve(12);
+    out = WriteDigits(out, time.hour(), 2);
+    *out++ = ':';
+    out = WriteDigits(out, time.minute(), 2);
+    *out++ = ':';
+    out = WriteDigits(out, time.second(), 2);
+    *out++ = '.';
+    out = WriteDigits(out, time.msec(), 3);
+    used_ = out - buffer_.constData();
+    return true;
+}
+
+bool outfit::utils::csv::CsvWriter::AppendDateTime(const QVariant& value) {
+    // Qt::ISODateWithMs; only local time (no suffix) and UTC ("Z") are handled here.
+    const auto& date_time = *static_cast<const QDateTime*>(value.constData());
+    const Qt::TimeSpec spec = date_time.timeSpec();
+    if (!date_time.isValid() || (spec != Qt::LocalTime && spec != Qt::UTC)) {
+        return false;
+    }
+    const QDate date = date_time.date();
+    if (date.year() < 1 || date.year() > 9999) {
+        return false;
+    }
+    AppendDate(date);
+    Append('T');
+    AppendTime(date_time.time());
+    if (spec == Qt::UTC) {
+        Append('Z');
+    }
+    return true;
+}
+
+bool outfit::utils::csv::ExportQuery(const QString& header, QSqlQuery& query, QIODevice& device) {
+    return ExportQuery(header, query, device, {});
+}
+
+bool outfit::utils::csv::ExportQuery(
+    const QString& header, QSqlQuery& query, QIODevice& device, const ProgressCallback& progress) {
+    ExportStats stats;
+    return ExportQuery(header, query, device, progress, stats);
+}
+
+bool outfit::utils::csv::ExportQuery(
+    const QString& header, QSqlQuery& query, QIODevice& device, const ProgressCallback& progress,
+    ExportStats& stats) {
+    QueryCursor cursor(query);
+    return ExportCursor(header, cursor, device, progress, stats);
+}
+
+bool outfit::utils::csv::ExportCursor(
+    const QString& header, RowCursor& cursor, QIODevice& device, const ProgressCallback& progress) {
+    ExportStats stats;
+    return ExportCursor(header, cursor, device, progress, stats);
+}
+
+bool outfit::utils::csv::ExportCursor(
+    const QString& header, RowCursor& cursor, QIODevice& device, const ProgressCallback& progress,
+    ExportStats& stats) {
+    return ExportCursor(header, true, cursor, device, progress, stats);
+}
+
+bool outfit::utils::csv::ExportCursor(
+    const QString& header, bool write_header, RowCursor& cursor, QIODevice& device,
+    const ProgressCallback& progress, ExportStats& stats) {
+    CsvWriter writer(&device);
+    if (write_header) {
+        writer.WriteLine(header);
+    }
+    writer.SetColumns(cursor.Record());
+    qint64 rows = 0;
+    RowBatch batch;
+    bool stopped = false;
+    while (!writer.HasError() && !stopped) {
+        const Timer fetch_timer;
+        const bool fetched = cursor.Next(batch);
+        stats.fetch += fetch_timer.GetTimes().wall_time;
+        if (!fetched) {
+            break;
+        }
+        const std::chrono::nanoseconds write_time = writer.WriteTime();
+        const Timer format_timer;
+        writer.WriteBatch(batch);
+        stats.format += format_timer.GetTimes().wall_time - (writer.WriteTime() - write_time);
+        rows += batch.Rows();
+        stopped = progress && !progress({rows, writer.BytesWritten()});
+    }
+    const bool flushed = writer.Flush();
+    stats.write += writer.WriteTime();
+    stats.rows += rows;
+    stats.bytes += writer.BytesWritten();
+    stats.max_row_width = std::max(stats.max_row_width, writer.MaxRowWidth());
+    if (stopped || !flushed || !cursor.Error().isEmpty()) {
+        return false;
+    }
+    return !progress || progress({rows, writer.BytesWritten()});
+}
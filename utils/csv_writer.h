@@ -0,0 +1,144 @@
+#ifndef CREATIVE_CSV_WRITER_H
+#define CREATIVE_CSV_WRITER_H
+
+#include "csv_cursor.h"
+#include "csv_stats.h"
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QDate>
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringEncoder>
+#include <QStringView>
+#include <QTime>
+#include <QVariant>
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace outfit::utils::csv {
+// Formats CSV rows straight into a reusable UTF-8 buffer and hands it to the device in
+// large blocks. Fields are escaped by the same rules as EscapeCSV.
+//
+// Numbers, booleans, dates and times are formatted without going through QString, with the
+// same text QVariant::toString() produces; anything else falls back to toString().
+class CsvWriter {
+   public:
+    static constexpr qsizetype kDefaultBlockSize = qsizetype{1} << 20;
+
+    explicit CsvWriter(QIODevice* device, qsizetype block_size = kDefaultBlockSize);
+    ~CsvWriter();
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+    CsvWriter(CsvWriter&&) = delete;
+    CsvWriter& operator=(CsvWriter&&) = delete;
+
+    void WriteLine(QStringView line);
+    void WriteField(QStringView field);
+    // Picks a formatter per column from the field types; call once per query before WriteRow.
+    // A column is re-planned if the driver returns values of a different type.
+    void SetColumns(const QSqlRecord& record);
+    void WriteRow(const QSqlQuery& query);
+    void WriteBatch(const RowBatch& batch);
+    void WriteValue(const QVariant& value, int column);
+
+    bool Flush();
+
+    [[nodiscard]] bool HasError() const {
+        return has_error_;
+    }
+
+    [[nodiscard]] qint64 BytesWritten() const {
+        return bytes_written_;
+    }
+
+    // Time spent in QIODevice::write, measured per block.
+    [[nodiscard]] std::chrono::nanoseconds WriteTime() const {
+        return write_time_;
+    }
+
+    // Longest row written by WriteRow or WriteBatch, in bytes.
+    [[nodiscard]] qint64 MaxRowWidth() const {
+        return max_row_width_;
+    }
+
+   private:
+    enum class Format : quint8 {
+        kGeneric,
+        kText,
+        kInt,
+        kUInt,
+        kLongLong,
+        kULongLong,
+        kDouble,
+        kBool,
+        kDate,
+        kTime,
+        kDateTime,
+    };
+
+    struct Column {
+        int type_id;
+        Format format;
+    };
+
+    static Format FormatFor(int type_id);
+
+    char* Reserve(qsizetype bytes);
+    void Append(QStringView text);
+    void Append(char c);
+    template <class T>
+    void AppendNumber(T value);
+    bool AppendDouble(double value);
+    bool AppendDate(QDate date);
+    bool AppendTime(QTime time);
+    bool AppendDateTime(const QVariant& value);
+
+    QIODevice* device_;
+    std::vector<Column> columns_;
+    QByteArray buffer_;
+    qsizetype used_ = 0;
+    QStringEncoder encoder_{QStringEncoder::Utf8};
+    qint64 bytes_written_ = 0;
+    std::chrono::nanoseconds write_time_{};
+    qint64 max_row_width_ = 0;
+    bool has_error_ = false;
+};
+
+struct ExportProgress {
+    qint64 rows = 0;
+    qint64 bytes = 0;
+};
+
+// Called after every batch of rows; returning false stops the export.
+using ProgressCallback = std::function<bool(const ExportProgress&)>;
+
+// Writes the header line, which is an empty line for an empty header, and every remaining row
+// of the cursor. Returns false on a write error, a cursor error or when the progress callback
+// asked to stop.
+bool ExportCursor(
+    const QString& header, RowCursor& cursor, QIODevice& device, const ProgressCallback& progress);
+// Also adds the fetch, format and write times and the counters to stats.
+bool ExportCursor(
+    const QString& header, RowCursor& cursor, QIODevice& device, const ProgressCallback& progress,
+    ExportStats& stats);
+// Without write_header only the rows are written, for appending to an earlier export.
+bool ExportCursor(
+    const QString& header, bool write_header, RowCursor& cursor, QIODevice& device,
+    const ProgressCallback& progress, ExportStats& stats);
+
+// ExportCursor over a QueryCursor. Execute the query forward-only to keep drivers from
+// caching the whole result set.
+bool ExportQuery(const QString& header, QSqlQuery& query, QIODevice& device);
+bool ExportQuery(
+    const QString& header, QSqlQuery& query, QIODevice& device, const ProgressCallback& progress);
+bool ExportQuery(
+    const QString& header, QSqlQuery& query, QIODevice& device, const ProgressCallback& progress,
+    ExportStats& stats);
+}  // namespace outfit::utils::csv
+
+#endif  // CREATIVE_CSV_WRITER_H
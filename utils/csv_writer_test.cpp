@@ -0,0 +1,68 @@
+#include "csv_writer.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QMetaType>
+#include <QSqlField>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringLiteral>
+#include <QVariant>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+// What CsvWriter writes for a single value, without the line break.
+QByteArray Written(const QVariant& value) {
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    {
+        outfit::utils::csv::CsvWriter writer(&buffer);
+        QSqlRecord record;
+        record.append(QSqlField(QStringLiteral("value"), value.metaType()));
+        writer.SetColumns(record);
+        writer.WriteValue(value, 0);
+    }
+    return buffer.data();
+}
+}  // namespace
+
+TEST_CASE("CsvWriter formats doubles like QVariant::toString") {
+    std::vector<double> values = {
+        0.,
+        -0.,
+        1e-4,
+        1e-5,
+        1e5,
+        1.2e6,
+        1e16,
+        0.1,
+        -0.00012,
+        123456.,
+        12345.678,
+        1. / 3.,
+        std::numeric_limits<double>::denorm_min(),
+        -std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::min() / 3.,
+        std::numeric_limits<double>::min(),
+        std::numeric_limits<double>::max(),
+        std::numeric_limits<double>::lowest(),
+        std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(),
+        std::numeric_limits<double>::quiet_NaN(),
+    };
+    // Both sides of the fixed/exponent switch for one and for several significant digits.
+    for (int exponent = -20; exponent <= 20; ++exponent) {
+        values.push_back(std::pow(10., exponent));
+        values.push_back(-1.25 * std::pow(10., exponent));
+        values.push_back(1.2345678901234567 * std::pow(10., exponent));
+    }
+    for (const double value : values) {
+        CAPTURE(value);
+        CHECK(Written(value) == QVariant(value).toString().toUtf8());
+    }
+}